@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "AllocStats.h"
+
+#ifdef DSMOD_ALLOC_STATS
+
+#include <cstdlib>
+#include <new>
+
+static void *Count(void *p, size_t size) {
+    if (!p)
+        throw std::bad_alloc();
+    AllocStats::t_counters.allocations++;
+    AllocStats::t_counters.bytes += size;
+    return p;
+}
+
+static void *AlignedAlloc(size_t size, std::align_val_t align) {
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, (size_t)align);
+#else
+    void *p = nullptr;
+    return posix_memalign(&p, (size_t)align, size ? size : 1) ? nullptr : p;
+#endif
+}
+
+static void AlignedFree(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void *operator new(size_t size) {
+    return Count(malloc(size ? size : 1), size);
+}
+
+void *operator new[](size_t size) {
+    return Count(malloc(size ? size : 1), size);
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+    return Count(AlignedAlloc(size, align), size);
+}
+
+void *operator new[](size_t size, std::align_val_t align) {
+    return Count(AlignedAlloc(size, align), size);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    AlignedFree(p);
+}
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+    AlignedFree(p);
+}
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made by the mod, per thread.
+//
+// Builds with DSMOD_ALLOC_STATS (Debug builds of the mod) replace the DLL's
+// global operator new / delete with ones that count into the calling
+// thread's counters; the game's own allocations don't go through them.
+// HookTimer takes the difference over every hook, so HookStats::Dump shows
+// which hooks still allocate once the game is past its first frames.
+namespace AllocStats {
+    struct Counters {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    // only counts in DSMOD_ALLOC_STATS builds
+    inline thread_local Counters t_counters;
+}
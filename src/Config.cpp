@@ -4,34 +4,123 @@
  */
 
 #include "Config.h"
+#include "IniFile.h"
 #include "Logger.h"
-#include <windows.h>
+
+#include <string_view>
+
+static uint32_t ParseLogCategories(std::string_view list) {
+    static const struct {
+        const char *name;
+        uint32_t category;
+    } categories[] = {
+        { "sigscan",   LOG_SIGSCAN   },
+        { "hooks",     LOG_HOOKS     },
+        { "ammo",      LOG_AMMO      },
+        { "fsm",       LOG_FSM       },
+        { "transport", LOG_TRANSPORT },
+        { "all",       LOG_ALL       },
+    };
+
+    uint32_t mask = 0;
+    while (!list.empty()) {
+        const size_t end = list.find_first_of(", \t");
+        const std::string_view tok = list.substr(0, end);
+        list.remove_prefix(end == std::string_view::npos ?
+                list.size() : end + 1);
+        if (tok.empty())
+            continue;
+        bool found = false;
+        for (auto& c : categories) {
+            if (IniFile::IEquals(tok, c.name)) {
+                mask |= c.category;
+                found = true;
+            }
+        }
+        if (!found)
+            _LOGW(LOG_ALL, "Unknown log category '%.*s' ignored",
+                    (int)tok.size(), tok.data());
+    }
+    return mask;
+}
 
 /*
  * sample INI content:
  *
  * [app]
  * debug=true
+ * trace=false
+ * timeline=false
+ * record=false
+ * log_level=debug
+ * log_categories=sigscan,hooks,ammo,fsm,transport
+ * pause_threshold_ms=350
+ * stats_interval_s=300
+ * trigger_rate_hz=60
  *
  */
 
 Config::Config (const char *iniPath) {
-    char value[255] = "";
-
-    GetPrivateProfileStringA("app", "debug", "false", value, sizeof(value), iniPath);
-    isDebugMode = strcmp(value, "true") == 0;
-
-    if (GetLastError() == ERROR_FILE_NOT_FOUND) {
+    IniFile ini;
+    if (!ini.Load(iniPath)) {
         _LOG("%s is not an INI file; using config defaults...", iniPath);
-        isDebugMode = false;
         return;
     }
 
-    memset(value, 0, sizeof(value));
+    ini.Get("app", "debug", isDebugMode);
+    ini.Get("app", "trace", isTraceMode);
+    ini.Get("app", "timeline", isTimelineMode);
+    ini.Get("app", "record", isRecordMode);
+
+    if (isDebugMode || isTraceMode) {
+        std::string_view list = "all";
+        ini.Get("app", "log_categories", list);
+        uint32_t categories = ParseLogCategories(list);
+        logMask = LOG_DEBUG_BIT(categories);
+
+        std::string_view level = "debug";
+        ini.Get("app", "log_level", level);
+        if (IniFile::IEquals(level, "trace"))
+            logMask |= LOG_TRACE_BIT(categories);
+    }
+
+    uint64_t threshold = pauseThresholdMs;
+    ini.Get("app", "pause_threshold_ms", threshold);
+    // below a couple of frames at 30 fps we'd pause on every hitch
+    if (threshold >= 100 && threshold <= 5000)
+        pauseThresholdMs = threshold;
+    else
+        _LOG("pause_threshold_ms=%llu is out of range [100, 5000]; using %llu",
+                (unsigned long long) threshold,
+                (unsigned long long) pauseThresholdMs);
+
+    ini.Get("app", "stats_interval_s", statsIntervalSec);
+
+    uint32_t rate = triggerRateHz;
+    ini.Get("app", "trigger_rate_hz", rate);
+    if (rate == 0 || (rate >= 10 && rate <= 1000))
+        triggerRateHz = rate;
+    else
+        _LOG("trigger_rate_hz=%u is out of range [10, 1000] (or 0); using %u",
+                rate, triggerRateHz);
+
+    for (const IniFile::Error& e : ini.Errors())
+        _LOGW(LOG_ALL, "%s:%d: %s; ignored", iniPath, e.line,
+                e.message.c_str());
 }
 
 void Config::print() {
-    _LOG("Config: [debug mode: %s]",
-        isDebugMode ? "true" : "false"
+    _LOG("Config: [debug mode: %s, trace mode: %s, timeline: %s, "
+            "record: %s, log mask: 0x%08x, "
+            "pause threshold: %llu ms, stats interval: %u s, "
+            "trigger rate: %u Hz]",
+        isDebugMode ? "true" : "false",
+        isTraceMode ? "true" : "false",
+        isTimelineMode ? "true" : "false",
+        isRecordMode ? "true" : "false",
+        logMask,
+        (unsigned long long) pauseThresholdMs,
+        statsIntervalSec,
+        triggerRateHz
     );
 }
@@ -5,10 +5,29 @@
 
 #pragma once
 
+#include <cstdint>
+
 class Config
 {
 public:
     bool isDebugMode = false;
+    // debug logs go to a binary trace, decoded offline by tools/trace-decode
+    bool isTraceMode = false;
+    // records hooks, state transitions and trigger sends into an in-memory
+    // timeline, exported as Chrome trace JSON on pause and at exit
+    bool isTimelineMode = false;
+    // records the game events the mod reacts to, for tools/replay
+    bool isRecordMode = false;
+    // enabled debug (low half) and trace (high half) log categories; see
+    // LogCategory in Logger.h
+    uint32_t logMask = 0;
+    // how long idHandsUpdate has to stall before we consider the game paused
+    uint64_t pauseThresholdMs = 350;
+    // how often per-hook latency stats are dumped to the log (0: only at exit)
+    uint32_t statsIntervalSec = 300;
+    // cap on the trigger commands sent to the service per second (0: none);
+    // the newest command waits out the cap, the ones in between are dropped
+    uint32_t triggerRateHz = 60;
     Config() : isDebugMode(false) {};
     Config(const char *iniPath);
     void print();
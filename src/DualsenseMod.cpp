@@ -8,6 +8,15 @@
 #include "Logger.h"
 #include "Config.h"
 #include "Utils.h"
+#include "GameState.h"
+#include "GameHooks.h"
+#include "HookStats.h"
+#include "Offsets.h"
+#include "Timeline.h"
+#include "Pipeline.h"
+#include "Recorder.h"
+#include "Scheduler.h"
+#include "TriggerProfiles.h"
 #include "rva/RVA.h"
 #include "minhook/include/MinHook.h"
 
@@ -26,14 +35,19 @@
 #include <cstdlib>
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <sstream>
 #include <thread>
 #include <chrono>
 #include <mutex>
-#include <map>
+#include <vector>
 
 #define INI_LOCATION "./mods/dualsense-mod.ini"
+#define TRACE_LOCATION "./mods/dualsensemod.trace"
+#define RECORD_LOCATION "./mods/dualsensemod.rec"
+#define PROFILES_LOCATION "./mods/dualsense-mod-triggers.ini"
+#define OFFSETS_LOCATION "./mods/dualsense-mod-offsets.ini"
 
 // TODO: move the following to a server utils file
 
@@ -66,46 +80,6 @@ bool launchServerElevated (
     return true;
 }
 
-bool scheduledTaskExists(std::string taskName) {
-    std::string query = "schtasks /query /TN \"" + taskName + "\" >nul 2>&1";
-    int result = WinExec(query.c_str(), SW_HIDE);
-    _LOG("Task exists: %d", result);
-    return (result > 31);
-}
-
-bool launchServerTask() {
-    std::string command = "schtasks /run /TN \"DualSensitive Service\" /I";
-    int result = WinExec(command.c_str(), SW_HIDE);
-    return (result > 31);
-}
-
-// schtasks /Create /TN "DualSensitive Service" /TR "wscript.exe \"C:\Program Files (x86)\Steam\steamapps\common\DOOM\mods\DualSensitive\launch-service.vbs\" \"C:\Program Files (x86)\Steam\steamapps\common\DOOM\mods\DualSensitive\dualsensitive-service.exe\"" /SC ONCE /ST 00:00 /RL HIGHEST /F
-
-bool launchServerTaskOrElevated() {
-    std::string taskName = "DualSensitive Service";
-    if (scheduledTaskExists(taskName.c_str())) {
-        std::string command("schtasks /run /TN \"" + taskName + "\" /I ");
-        _LOG("Running task, command: %s", command.c_str());
-        int result = WinExec(command.c_str(), SW_HIDE);
-        if (result > 31){
-            _LOG("Service ran successfully");
-            return true;
-        }
-        _LOG("Running task failed (code: %d). Falling back to elevation.", result);
-    } else {
-        _LOG("Scheduled task not found. Falling back to elevation.");
-    }
-
-    // Final fallback
-    if (!launchServerElevated()) {
-        _LOG("Fallback elevation also failed. Check permissions or try manually running dualsensitive-service.exe.");
-        return false;
-    }
-
-    return true;
-}
-
-
 bool terminateServer(PROCESS_INFORMATION& procInfo) {
     if (procInfo.hProcess != nullptr) {
         BOOL result = TerminateProcess(procInfo.hProcess, 0); // 0 = exit code
@@ -150,42 +124,104 @@ void logLastError(const char* context) {
     }
 }
 
-struct TriggerSetting {
-    TriggerProfile profile;
-    bool isCustomTrigger = false;
-    TriggerMode mode = TriggerMode::Off;
-    std::vector<uint8_t> extras;
+// Runs a console command without a window and waits for it to exit; returns
+// false if it couldn't be run or didn't finish in time
+static bool runHidden(const std::string& commandLine, DWORD& exitCode,
+        DWORD timeoutMs = 10000) {
+    STARTUPINFOA si = { sizeof(si) };
+    PROCESS_INFORMATION pi = {};
+    // CreateProcessA may write to the command line buffer
+    std::string command = commandLine;
+    if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE,
+                CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+        logLastError("CreateProcess");
+        return false;
+    }
+    const DWORD wait = WaitForSingleObject(pi.hProcess, timeoutMs);
+    if (wait == WAIT_TIMEOUT)
+        TerminateProcess(pi.hProcess, 1);
+    const bool ok = wait == WAIT_OBJECT_0 &&
+        GetExitCodeProcess(pi.hProcess, &exitCode);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return ok;
+}
 
-    TriggerSetting(TriggerProfile profile, std::vector<uint8_t> extras) :
-        profile(profile), extras(extras) {}
+// The installer creates the task; it doesn't come and go while the game is
+// running, so schtasks is only asked once
+bool scheduledTaskExists(const std::string& taskName) {
+    static const bool exists = [&taskName] {
+        DWORD exitCode = 1;
+        const bool found = runHidden (
+                "schtasks /query /TN \"" + taskName + "\"", exitCode
+        ) && exitCode == 0;
+        _LOG("Task exists: %d", found);
+        return found;
+    }();
+    return exists;
+}
 
-    TriggerSetting(TriggerMode mode, std::vector<uint8_t> extras) :
-        mode(mode), extras(extras), isCustomTrigger(true) {}
+bool launchServerTask(const std::string& taskName) {
+    DWORD exitCode = 1;
+    std::string command("schtasks /run /TN \"" + taskName + "\" /I");
+    _LOG("Running task, command: %s", command.c_str());
+    if (!runHidden(command, exitCode))
+        return false;
+    if (exitCode != 0)
+        _LOG("Running task failed (exit code: %lu)", exitCode);
+    return exitCode == 0;
+}
 
-};
+// schtasks /Create /TN "DualSensitive Service" /TR "wscript.exe \"C:\Program Files (x86)\Steam\steamapps\common\DOOM\mods\DualSensitive\launch-service.vbs\" \"C:\Program Files (x86)\Steam\steamapps\common\DOOM\mods\DualSensitive\dualsensitive-service.exe\"" /SC ONCE /ST 00:00 /RL HIGHEST /F
 
-struct Triggers {
-    TriggerSetting *L2;
-    TriggerSetting *R2;
-};
+bool launchServerTaskOrElevated() {
+    std::string taskName = "DualSensitive Service";
+    if (scheduledTaskExists(taskName)) {
+        if (launchServerTask(taskName)) {
+            _LOG("Service ran successfully");
+            return true;
+        }
+        _LOG("Running task failed. Falling back to elevation.");
+    } else {
+        _LOG("Scheduled task not found. Falling back to elevation.");
+    }
+
+    // Final fallback
+    if (!launchServerElevated()) {
+        _LOGW(LOG_TRANSPORT, "Fallback elevation also failed. Check permissions or try manually running dualsensitive-service.exe.");
+        return false;
+    }
+
+    return true;
+}
+
+// Built-in trigger settings, used until (and unless) the profiles file
+// (PROFILES_LOCATION) loads
+static TriggerProfiles::Trigger TriggerSetting(TriggerProfile profile,
+        std::vector<uint8_t> extras) {
+    return { false, static_cast<int>(profile), std::move(extras) };
+}
+
+static TriggerProfiles::Trigger TriggerSetting(TriggerMode mode,
+        std::vector<uint8_t> extras) {
+    return { true, static_cast<int>(mode), std::move(extras) };
+}
 
 // Globals
 Config g_config;
 Logger g_logger;
 
-std::map<std::string, Triggers> g_TriggerSettings ;
-
-void InitTriggerSettings() {
-    g_TriggerSettings =
+TriggerProfiles::Table DefaultTriggerSettings() {
+    return
     {
         {
             "weapon/zion/player/sp/fists_berserk",
             {
 
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 )
             }
@@ -193,10 +229,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/fists",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 )
             }
@@ -204,11 +240,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/pistol",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Galloping,
                         {3, 9, 1, 2, 30}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Bow,
                         {1, 4, 3, 2}
                 )
@@ -217,10 +253,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/shotgun",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Bow,
                         {0, 4, 8, 8}
                 )
@@ -229,10 +265,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/shotgun_mod",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerMode::Rigid, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::MultiplePositionFeeback,
                         {4, 7, 0, 2, 4, 6, 0, 3, 6, 0}
                 )
@@ -241,10 +277,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/plasma_rifle",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Vibration,
                         {0, 4, 10}
                 )
@@ -253,10 +289,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/heavy_rifle_heavy_ar",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerMode::Rigid, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::MultiplePositionVibration,
                         {14, 0, 1, 2, 3, 4, 5, 6, 7, 8, 8}
                 )
@@ -265,10 +301,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/heavy_rifle_heavy_ar_mod",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerMode::Rigid, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::MultiplePositionVibration,
                         {15, 0, 1, 4, 6, 7, 8, 8, 7, 6, 4}
                 )
@@ -277,10 +313,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/rocket_launcher",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Bow,
                         {0, 3, 8, 8}
                 )
@@ -290,10 +326,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/rocket_launcher_mod",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerMode::Rigid, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerMode::Rigid_A,
                         {209, 42, 232, 192, 232, 209, 232}
                 )
@@ -302,11 +338,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/double_barrel",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerMode::Rigid_A,
                         {60, 71, 56, 128, 195, 210, 255}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                     TriggerProfile::SlopeFeedback,
                     {0, 8, 8, 1}
                 )
@@ -315,11 +351,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/chaingun",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Vibration,
                         {1, 10, 8}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::MultiplePositionVibration,
                         {11, 1, 3, 5, 7, 7, 8, 8, 8, 8, 8}
                 )
@@ -328,11 +364,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/chaingun_mod",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::SlopeFeedback,
                         {0, 5, 1, 8}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::MultiplePositionVibration,
                         {21, 1, 3, 5, 7, 7, 8, 8, 8, 8, 8}
                 )
@@ -341,11 +377,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/chainsaw",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Machine,
                         {1, 9, 1, 5, 100, 0}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Machine,
                         {1, 9, 7, 7, 65, 0}
                 )
@@ -354,11 +390,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/gauss_rifle",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Machine,
                         {7, 9, 0, 1, 8, 1}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Galloping,
                         {1, 3, 1, 6, 40}
                 )
@@ -367,11 +403,11 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/gauss_rifle_mod",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                         TriggerProfile::Machine,
                         {4, 9, 1, 2, 40, 0}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                         TriggerProfile::Galloping,
                         {1, 3, 1, 6, 40}
                 )
@@ -380,10 +416,10 @@ void InitTriggerSettings() {
         {
             "weapon/zion/player/sp/bfg",
             {
-                .L2 = new TriggerSetting (
+                .L2 = TriggerSetting (
                     TriggerProfile::Choppy, {}
                 ),
-                .R2 = new TriggerSetting (
+                .R2 = TriggerSetting (
                     TriggerMode::Pulse_AB,
                     {18, 197, 35, 58, 90, 120, 138}
                 )
@@ -392,218 +428,161 @@ void InitTriggerSettings() {
     };
 }
 
-bool hasModSettings(std::string weaponName);
-void SendTriggers(std::string weaponName, bool mod = false);
-void SendTriggers(std::string weaponName, bool mod) {
-    std::string weaponId = std::string(weaponName);
-    if (mod) {
-        if (!hasModSettings(weaponName)) {
-           _LOGD("* No mod settings found for %s", weaponName.c_str());
-           return;
+// What one of the controller's triggers was last set to, so that settings it
+// already has aren't written again: weapons often share their L2 settings,
+// and both the reset and the no-ammo state leave L2 normal
+class TriggerShadow
+{
+public:
+    // false if the trigger already has these settings
+    bool Update(bool custom, int value, const std::vector<uint8_t>& extras) {
+        if (m_valid && m_custom == custom && m_value == value &&
+                m_size == extras.size() &&
+                std::equal(extras.begin(), extras.end(), m_extras))
+            return false;
+        // longer extras than any profile takes are just always written
+        m_valid = extras.size() <= sizeof(m_extras);
+        if (m_valid) {
+            m_custom = custom;
+            m_value = value;
+            m_size = (uint8_t)extras.size();
+            std::copy(extras.begin(), extras.end(), m_extras);
         }
-        weaponId += "_mod";
+        return true;
     }
-    Triggers t = g_TriggerSettings[weaponId];
-    if (t.L2->isCustomTrigger)
-        dualsensitive::setLeftCustomTrigger(t.L2->mode, t.L2->extras);
-    else
-        dualsensitive::setLeftTrigger (t.L2->profile, t.L2->extras);
-    if (t.R2->isCustomTrigger)
-        dualsensitive::setRightCustomTrigger(t.R2->mode, t.R2->extras);
-    else
-        dualsensitive::setRightTrigger (t.R2->profile, t.R2->extras);
-    _LOGD("Adaptive Trigger settings sent successfully!");
-}
 
+    void Forget() { m_valid = false; }
 
-// Game structures
-using Player  = void;
-using Weapon  = void;
-
-// Game global vars
-
-HMODULE g_doomBaseAddr = nullptr;
-
-
-// found using FindCurrWeaponHandle (Player *player)
-static size_t g_currWeaponOffset = 0x9788;
-// = SIZE_MAX; // to search for the offset using FindCurrWeaponHandle
-
-static Weapon *g_currWeapon = nullptr;
-
-static Player *g_currPlayer = nullptr;
-
-static unsigned int g_previousMode = 0;
-
-enum class GameState : uint8_t {
-    Idle,       // Game hasn't started yet
-    InGame,     // Gameplay is on
-    Paused      // Game is paused
+private:
+    bool m_valid = false;
+    bool m_custom = false;
+    int m_value = 0;
+    uint8_t m_size = 0;
+    uint8_t m_extras[16];
 };
 
-static std::atomic<GameState> g_state{GameState::Idle};
-
-void print_state()
+// Sends the pipeline's decisions to the DualSensitive service
+class DualSensitiveSink : public TriggerSink
 {
-    switch(g_state) {
-        case GameState::Idle:
-            _LOGD("*current state: Idle");
-            break;
-        case GameState::InGame:
-            _LOGD("*current state: InGame");
-            break;
-        case GameState::Paused:
-            _LOGD("*current state: Paused");
-            break;
-        default:
-            _LOGD("*current state: Unknown");
+public:
+    void SendWeapon(const char *weaponId) override {
+        TIMELINE_SPAN("transport", "SendTriggers", weaponId);
+        // no lock: a reload can swap the table under us, this one stays
+        // valid until we're done with it
+        TriggerProfiles::Reader profiles;
+        const TriggerProfiles::Triggers *t = profiles.Find(weaponId);
+        if (!t) {
+            _LOGD(LOG_TRANSPORT, "* No trigger settings for %s", weaponId);
+            return;
+        }
+        checkForget();
+        if (m_L2.Update(t->L2.isCustomTrigger, t->L2.value, t->L2.extras)) {
+            TIMELINE_SPAN("transport", "send L2");
+            if (t->L2.isCustomTrigger)
+                dualsensitive::setLeftCustomTrigger(
+                        static_cast<TriggerMode>(t->L2.value), t->L2.extras);
+            else
+                dualsensitive::setLeftTrigger (
+                        static_cast<TriggerProfile>(t->L2.value), t->L2.extras);
+        }
+        if (m_R2.Update(t->R2.isCustomTrigger, t->R2.value, t->R2.extras)) {
+            TIMELINE_SPAN("transport", "send R2");
+            if (t->R2.isCustomTrigger)
+                dualsensitive::setRightCustomTrigger(
+                        static_cast<TriggerMode>(t->R2.value), t->R2.extras);
+            else
+                dualsensitive::setRightTrigger (
+                        static_cast<TriggerProfile>(t->R2.value), t->R2.extras);
+        }
     }
-}
 
-static std::vector<std::string> g_WeaponsWithModSettings = {
-    "weapon/zion/player/sp/shotgun",
-    "weapon/zion/player/sp/chaingun",
-    "weapon/zion/player/sp/rocket_launcher",
-    "weapon/zion/player/sp/heavy_rifle_heavy_ar",
-    "weapon/zion/player/sp/gauss_rifle",
-};
+    void Reset() override {
+        TIMELINE_SPAN("transport", "resetAdaptiveTriggers");
+        setBoth(TriggerProfile::Normal, TriggerProfile::Normal);
+    }
 
-static bool hasModSettings(std::string weaponName) {
-    return std::find (
-            g_WeaponsWithModSettings.begin(),
-            g_WeaponsWithModSettings.end(),
-            weaponName
-    ) != g_WeaponsWithModSettings.end();
-}
+    void NoAmmo() override {
+        TIMELINE_SPAN("transport", "noAmmoAdaptiveTriggers");
+        setBoth(TriggerProfile::Normal, TriggerProfile::GameCube);
+    }
 
-std::vector<std::string> g_AmmoList = {
-    "bullets",  // heavy_rifle_heavy_ar, chaingun
-    "shells",   // shotgun, double_barrel
-    "rockets",  // rocket_launcher
-    "plasma",   // plasma_rifle, gauss_rifle
-    "cells",    // bfg
-    "fuel"      // chainsaw
-};
+    // The controller may not have what we last sent (the service restarted,
+    // the controller reconnected): write everything on the next command.
+    // Any thread; the commands themselves are serialized by the Pipeline.
+    void Forget() { m_forget.store(true, std::memory_order_release); }
 
-// weapon name to ammo
-static std::unordered_map<std::string, std::string> g_WeaponToAmmoType = {
-  {"weapon/zion/player/sp/fists",                    "infinite"},
-  {"weapon/zion/player/sp/fists_berserk",            "infinite"},
-  {"weapon/zion/player/sp/pistol",                   "infinite"},
-  {"weapon/zion/player/sp/heavy_rifle_heavy_ar",     "bullets"},
-  {"weapon/zion/player/sp/heavy_rifle_heavy_ar_mod", "bullets"},
-  {"weapon/zion/player/sp/chaingun",                 "bullets"},
-  {"weapon/zion/player/sp/chaingun_mod",             "bullets"},
-  {"weapon/zion/player/sp/shotgun",                  "shells"},
-  {"weapon/zion/player/sp/shotgun_mod",              "shells"},
-  {"weapon/zion/player/sp/double_barrel",            "shells"},
-  {"weapon/zion/player/sp/rocket_launcher",          "rockets"},
-  {"weapon/zion/player/sp/rocket_launcher_mod",      "rockets"},
-  {"weapon/zion/player/sp/plasma_rifle",             "plasma"},
-  {"weapon/zion/player/sp/gauss_rifle",              "plasma"},
-  {"weapon/zion/player/sp/gauss_rifle_mod",          "plasma"},
-  {"weapon/zion/player/sp/bfg",                      "cells"},
-  {"weapon/zion/player/sp/chainsaw",                 "fuel"},
-};
+private:
+    void checkForget() {
+        if (m_forget.exchange(false, std::memory_order_acquire)) {
+            m_L2.Forget();
+            m_R2.Forget();
+        }
+    }
 
+    void setBoth(TriggerProfile left, TriggerProfile right) {
+        static const std::vector<uint8_t> none;
+        checkForget();
+        if (m_L2.Update(false, static_cast<int>(left), none))
+            dualsensitive::setLeftTrigger(left);
+        if (m_R2.Update(false, static_cast<int>(right), none))
+            dualsensitive::setRightTrigger(right);
+    }
 
-static std::unordered_map<std::string, void*> g_AmmoPtrs = {
-    {"bullets",  nullptr},
-    {"shells",   nullptr},
-    {"rockets",  nullptr},
-    {"plasma",   nullptr},
-    {"cells",    nullptr},
-    {"fuel",     nullptr}
+    TriggerShadow m_L2;
+    TriggerShadow m_R2;
+    std::atomic<bool> m_forget{false};
 };
 
-static void resetAmmoPtrs() {
-    g_AmmoPtrs = {
-        {"bullets",  nullptr},
-        {"shells",   nullptr},
-        {"rockets",  nullptr},
-        {"plasma",   nullptr},
-        {"cells",    nullptr},
-        {"fuel",     nullptr}
+static DualSensitiveSink g_dualSensitiveSink;
+
+// Names accepted in the profiles file
+static bool ResolveTrigger(const std::string& name, bool custom, int& value) {
+    static const struct {
+        const char *name;
+        TriggerProfile profile;
+    } profiles[] = {
+        { "Normal",                     TriggerProfile::Normal },
+        { "GameCube",                   TriggerProfile::GameCube },
+        { "Choppy",                     TriggerProfile::Choppy },
+        { "Galloping",                  TriggerProfile::Galloping },
+        { "Bow",                        TriggerProfile::Bow },
+        { "Machine",                    TriggerProfile::Machine },
+        { "Vibration",                  TriggerProfile::Vibration },
+        { "SlopeFeedback",              TriggerProfile::SlopeFeedback },
+        { "MultiplePositionFeeback",    TriggerProfile::MultiplePositionFeeback },
+        { "MultiplePositionVibration",  TriggerProfile::MultiplePositionVibration },
+    };
+    static const struct {
+        const char *name;
+        TriggerMode mode;
+    } modes[] = {
+        { "Off",        TriggerMode::Off },
+        { "Rigid",      TriggerMode::Rigid },
+        { "Rigid_A",    TriggerMode::Rigid_A },
+        { "Pulse_AB",   TriggerMode::Pulse_AB },
     };
-}
-
-static const unsigned int g_AmmoCountOffset = 0x38;
-
-// this is constructed dynamically
-static std::unordered_map<void*, bool> g_HasAmmo = {};
 
-static bool HasAmmo(std::string weaponName) {
-    std::string ammoType = g_WeaponToAmmoType[ weaponName ];
-    if (ammoType == "infinite")
-        return true;
-    void * ammo = g_AmmoPtrs[ammoType];
-    if (!ammo) {
-        _LOGD("HasAmmo - Ptr for %s found null!", ammoType.c_str());
+    if (custom) {
+        for (auto& m : modes) {
+            if (!_stricmp(name.c_str(), m.name)) {
+                value = static_cast<int>(m.mode);
+                return true;
+            }
+        }
         return false;
     }
-    return g_HasAmmo[ammo];
+    for (auto& p : profiles) {
+        if (!_stricmp(name.c_str(), p.name)) {
+            value = static_cast<int>(p.profile);
+            return true;
+        }
+    }
+    return false;
 }
 
+// Game global vars
 
-// Game functions
-using _OnWeaponSelected =
-                    void(__fastcall*)(void *player, long long *weapon);
-
-using _SelectWeaponByDeclExplicit =
-                    unsigned long long(__fastcall*) (
-                            long long *player, long long param_2,
-                            char param_3, char param_4
-                    );
-
-using _UpdateWeapon =
-                    void(__fastcall*) (void *player);
-
-
-using _Damage = void(__fastcall*)(
-    void* player,
-    void* inflictor,
-    void* attacker,
-    long long damageDecl,
-    float damageScale,
-    const float* dir,
-    const float* hitInfo
-);
-
-// Virtual: bool idPlayer::IsDead() const;
-// found at vtable + 0x6C8
-using _IsDead = bool(__fastcall*)(void* player);
-
-using _LevelLoadCompleted =
-                    void (__fastcall*)(long long *this_idLoadScreen);
-
-
-using _UpdateAmmo =
-                    int (__fastcall *)(void *ammo, int delta, char clamp);
-
-
-using _GetWeaponFromDecl =
-                    void* (__fastcall*)(long long* mgr, long long decl);
-
-using _SetFireMode =
-                    bool(__fastcall*) (
-                            void* weapon, uint32_t mode, char allowSame
-                    );
-
-using _idMenuManagerShell_Activate =
-                    void (__fastcall *)(void *self, uint32_t stateId);
-
-using _idHandsUpdate =
-                    void(__fastcall*) (void *self, void *state);
-
-// handle to pointer resolution. It takes a 64-bit handle/id and returns a real
-// object pointer (FUN_14142C870 for Vulkan and FUN_14142c7d0 for OpenGL)
-using _HandleToPointer  = Weapon* (__fastcall*)(uint64_t);
-
-// idPlayer's vtable + 0xB20
-using PlayerState  = uint32_t(__fastcall*)(Player*);
-
-// idPlayer's vtable +0x678
-using GetHandle    = uint64_t(__fastcall*)(Player*, uint32_t state);
+HMODULE g_doomBaseAddr = nullptr;
 
 
 // Game Addresses
@@ -614,7 +593,6 @@ OnWeaponSelected (
     "48 85 d2 74 ? 48 89 74 24 10 57 48 83 ec 20 83 3d ? ? ? ? 00 48 8b fa 48 "
     "8b f1 74 ?"
 );
-_OnWeaponSelected OnWeaponSelected_Original = nullptr;
 
 // This function inits player with all the weapons owned before game starts
 RVA<_SelectWeaponByDeclExplicit>
@@ -624,7 +602,6 @@ SelectWeaponByDeclExplicit (
     "83 3d ? ? ? ? 00 45 0f b6"
 
 );
-_SelectWeaponByDeclExplicit SelectWeaponByDeclExplicit_Original = nullptr;
 
 // This function signals that level loading is complete
 RVA<_LevelLoadCompleted>
@@ -633,14 +610,12 @@ LevelLoadCompleted (
     "48 89 5c 24 08 48 89 74 24 10 57 48 83 ec 20 48 8b d9 48 8d 0d ? ? ? "
     "01 e8 ? ? c0 fe"
 );
-_LevelLoadCompleted LevelLoadCompleted_Original = nullptr;
 
 // Function that applies damage to player
 RVA<_Damage>
 Damage (
     "48 8b c4 55 53 56 57 41 54 41 55 41 56 41 57 48 8d a8 18 f2 ff ff 48 81 ec"
 );
-_Damage Damage_Original = nullptr;
 
 // Function that gets a handle and resolves it to a pointer, useful to get
 // weapon object from player object
@@ -663,7 +638,6 @@ UpdateWeapon (
 
     "40 55 53 57 48 8d ac 24 f0 fb ff ff 48 81 ec 10 05 00 00 48 8b 05"
 );
-_UpdateWeapon UpdateWeapon_Original = nullptr;
 
 // Function that updates weapon's ammo; we hook it to keep track of the
 // capability of the weapnons to fire or not
@@ -672,7 +646,6 @@ UpdateAmmo(
     "48 89 5c 24 08 48 89 74 24 10 57 48 83 ec 20 33 ff 48 8b d9 45 84 c0 74 "
     "08 39 79 38"
 );
-_UpdateAmmo UpdateAmmo_Original = nullptr;
 
 // Function to get initiate weapons; we're using it to get the first weapon that
 // slayer has when enters the game
@@ -687,98 +660,31 @@ SetFireMode(
     "44 88 44 24 18 55 56 57 41 54 41 55 41 56 41 57 48 83 ec 60 48 c7 44 24 "
     "40 fe ff ff ff 48 89"
 );
-_SetFireMode SetFireMode_Original = nullptr;
 
 RVA<_idHandsUpdate>
 idHandsUpdate(
     "48 8b c4 55 56 57 41 54 41 55 41 56 41 57 48 8d a8 38 f3 ff ff 48 81 ec "
     "90 0d 00 00 48 c7 85 a0"
 );
-_idHandsUpdate idHandsUpdate_Original = nullptr;
-
-// Utility functions
 
-using GetMgr_t = void* (__fastcall*)(Player* player);
-inline void* GetWeaponMgr(Player* player) {
-    auto vtbl = *reinterpret_cast<void***>(player);
-    auto fn   = reinterpret_cast<GetMgr_t>(vtbl[0x660/8]);  // 0x660 / 8 = 0xCC
-    return fn(player);
-}
-
-static inline uint32_t GetPlayerState(Player* player) {
-    auto vtable = *reinterpret_cast<void***>(player);
-    return reinterpret_cast<PlayerState>(vtable[0xB20/8])(player);
-}
-
-static inline uint64_t GetPlayerHandle(Player* player, uint32_t state) {
-    auto vtable = *reinterpret_cast<void***>(player);
-    return reinterpret_cast<GetHandle>(vtable[0x678/8])(player, state);
-}
-
-static inline char *GetWeaponName(long long* weapon) {
-    if (!weapon) return nullptr;
-    return (char *)(*(long long *)(weapon[6] + 8));
-}
-
-// Utility functions to get the idPlayer's current weapon handle
-static size_t FindOffsetByQword(void* base, uint64_t value,
-        size_t limit=0x20000) {
-    auto b = reinterpret_cast<const uint8_t*>(base);
-    for (size_t off = 0; off + 8 <= limit; off += 8) {
-        if (*reinterpret_cast<const uint64_t*>(b + off) == value) return off;
-    }
-    return SIZE_MAX;
-}
+// Globals
 
-// XXX This function is unused, it's only needed in case of a game update
-// to find out where the new weapon offset is
-static void FindCurrWeaponHandle (Player *player) {
-    auto state = GetPlayerState(player);
-    auto handle = GetPlayerHandle(player, state);
-    if (!handle) {
-        _LOGD("Player handle is NULL");
-        return;
-    }
-    _LOGD("Player state=%u handle=%p", state, (void*)handle);
+// Service startup runs on the scheduler: launching the service, then
+// connecting the client to it (retried with backoff), so that the PID is
+// sent to the server after the server has started
+static std::chrono::steady_clock::time_point g_initStart;
 
-    if (handle && g_currWeaponOffset==SIZE_MAX ) {
-        g_currWeaponOffset = FindOffsetByQword(player, handle);
-        _LOGD("player->currentWeaponHandle offset = %zu\n", g_currWeaponOffset);
-    }
+// ms since Init() started / since t
+static double sinceInitMs() {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - g_initStart).count();
 }
 
-static Weapon *GetCurrentWeaponAlter (Player *player) {
-    uint64_t h2  = *(uint64_t*)((uint8_t*)player + 0x9788);
-    void*    p2  = HandleToPointer(h2);
-    return (Weapon*)p2;
+static double sinceMs(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t).count();
 }
 
-static inline Weapon *GetCurrentWeapon (Player *player) {
-    if (!player || !HandleToPointer) {
-        _LOGD("Player or HandleToPointer is NULL");
-        return nullptr;
-    }
-
-    // read 64-bit handle the engine stores in idPlayer
-    const auto handle = *reinterpret_cast <const uint64_t *> (
-        reinterpret_cast <const uint8_t *> (player) + g_currWeaponOffset
-    );
-
-    if (!handle) {
-        _LOGD("Player handle is NULL");
-        return nullptr;
-    }
-
-    return HandleToPointer(handle);
-}
-
-// Globals
-
-// This is to make sure that the PID will be sent to the server after
-// the server has started
-std::mutex g_serverLaunchMutex;
-bool g_serverStarted = false;
-
 namespace DualsenseMod {
 
     // Read and populate offsets and addresses from game code
@@ -825,7 +731,7 @@ namespace DualsenseMod {
         );
 
         if (!g_doomBaseAddr) {
-            _LOGD("DOOM base address is not set!");
+            _LOGW(LOG_SIGSCAN, "DOOM base address is not set!");
             return false;
         }
 
@@ -842,425 +748,118 @@ namespace DualsenseMod {
             )
             return false;
 
+        Hooks::HandleToPointer = HandleToPointer;
+        Hooks::GetWeaponFromDecl = GetWeaponFromDecl;
         return true;
     }
 
-    void resetAdaptiveTriggers() {
-        dualsensitive::setLeftTrigger(TriggerProfile::Normal);
-        dualsensitive::setRightTrigger(TriggerProfile::Normal);
-        _LOGD("Adaptive Triggers reset successfully!");
+    // Called by the pause watcher thread. Opening the menu is also how a
+    // player snapshots the timeline, right after something went wrong.
+    void onGamePaused() {
+        Pipeline::OnPaused();
+        if (Timeline::Enabled() && !Timeline::Export(TIMELINE_LOCATION))
+            _LOGW(LOG_ALL, "Failed to write %s", TIMELINE_LOCATION);
     }
 
+    // A detour and the game function it goes on
+    struct HookEntry {
+        const char *name;
+        LPVOID target;
+        LPVOID detour;
+        LPVOID *original;
+    };
 
-    void noAmmoAdaptiveTriggers() {
-        dualsensitive::setLeftTrigger(TriggerProfile::Normal);
-        dualsensitive::setRightTrigger(TriggerProfile::GameCube);
-        _LOGD("No Ammo Adaptive Triggers set successfully!");
-    }
-
-    void sendAdaptiveTriggersForCurrentWeapon(bool mod = false);
-    void sendAdaptiveTriggersForCurrentWeapon(bool mod) {
-        char * currWeaponName = GetWeaponName (
-                reinterpret_cast<long long*>(g_currWeapon)
-        );
-        _LOGD("* curr weapon: %s!", currWeaponName);
-        if (currWeaponName && HasAmmo(currWeaponName)){
-            _LOGD("* Sending adaptive trigger setting!");
-            SendTriggers(currWeaponName, mod);
-            return;
-        }
-        _LOGD("* No valid weapon name or no ammo - resetting triggers!");
-        noAmmoAdaptiveTriggers();
-    }
-
-    void OnWeaponSelected_Hook(void *player, long long *weapon) {
-        _LOGD("* OnWeaponSelected hook!!!");
-
-        if (weapon == nullptr) {
-            OnWeaponSelected_Original(player, weapon);
-            return;
-        }
-
-        char *weaponName =  GetWeaponName(weapon);
-        g_currWeapon = weapon;
-        bool hasAmmo = HasAmmo(weaponName);
-        _LOGD (
-                "idPlayer::OnWeaponSelected - newWeapon = %s, hasAmmo: %s\n",
-                weaponName, hasAmmo ? "true" : "false"
-        );
-        sendAdaptiveTriggersForCurrentWeapon();
-        OnWeaponSelected_Original(player, weapon);
-
-        // XXX uncomment to find the idPlayer's current weapon handler
-        // if there is a new update of the game out
-        //FindCurrWeaponHandle((Player *) player);
-
-        return;
-    }
-
-    void UpdateWeapon_Hook (void *player) {
-
-        if (!g_currPlayer) {
-            _LOGD("* set idPlayer!");
-            g_currPlayer = player;
-        }
-
-        UpdateWeapon_Original(player);
-        return;
-    }
-
-
-int UpdateAmmo_Hook (void *ammo, int delta, char clamp) {
-    int ret = UpdateAmmo_Original(ammo, delta, clamp);
-    if (!ammo)
-        return ret;
-    int* pCount = (int*)((uint8_t*)ammo + g_AmmoCountOffset);
-    int  count  = *pCount;
-    _LOGD("* UpdateAmmo hook! ammo ptr: %p, delta: %d, clamp: %d, AMMO: %d",
-            ammo,
-            delta,
-            clamp,
-            count
-    );
-
-    if (count <= 0 && g_HasAmmo[ammo])
-        g_HasAmmo[ammo] = false;
-    if (count > 0 && !g_HasAmmo[ammo])
-        g_HasAmmo[ammo] = true;
-
-    if (!g_currWeapon) {
-        return ret;
-    }
-
-    char *weapon_str = GetWeaponName (
-            reinterpret_cast<long long*>(g_currWeapon)
-    );
-    if (!weapon_str) {
-        return ret;
-    }
-
-    std::string weaponName = std::string(weapon_str);
-    std::string ammoType = g_WeaponToAmmoType[weaponName];
-    if (ammoType == "infinite")
-        return ret;
-    if (!g_AmmoPtrs[ammoType]) {
-        g_AmmoPtrs[ammoType] = ammo;
-        _LOGD("g_AmmoPtrs[%s] = %p, |(%p)|",
-                ammoType.c_str(), ammo, g_AmmoPtrs[ammoType]
-        );
-    }
-
-    return ret;
-}
-
-enum TriggerState : int { TS_Idle=0, TS_Pressed=1, TS_Held=2, TS_Released=3};
-
-static inline int GetSelectedMode(void* weapon) {
-    return weapon ? *reinterpret_cast<int*>((uint8_t*)weapon + 0x8D4) : -1;
-}
-
-bool SetFireMode_Hook(void* weapon, uint32_t mode, char allowSame) {
-    // This tells us if mod is active (i.e., if left trigger is pressed)
-    // XXX NOTE: we should check allowSame and other fields based on the
-    // Ghidra source as we might discover which mode is active, if the gun
-    // can still fire or if the mod is in charging state, etc.
-    bool ok = SetFireMode_Original(weapon, mode, allowSame);
-    if (!g_currPlayer || !g_currWeapon)
-        return ok;
-    if (ok && mode != g_previousMode) {
-        print_state();
-        _LOGD("* SetFireMode hook! weapon: %p, curr weapon: %p  "
-                "| g_previousMode: %d, current: %d",
-                weapon, g_currWeapon,
-                g_previousMode, mode
-        );
-        sendAdaptiveTriggersForCurrentWeapon((bool)mode);
-    }
-    g_previousMode = mode;
-    return ok;
-}
-
-
-
-static inline bool CallIsDead(void* player);
-static std::atomic<uint64_t> g_lastHandsBeat{0}; // perf counter in ms
-//static std::atomic<bool>     g_inLoad{false};
-static inline uint64_t NowMs();
-
-void idHandsUpdate_Hook(void *self, void * state) {
-    idHandsUpdate_Original(self, state);
-    if (g_state.load() == GameState::Idle)
-        return;
-    // Always tick the heartbeat when we are truly in gameplay.
-    if (g_currPlayer && !CallIsDead(g_currPlayer)) {
-        g_lastHandsBeat.store(NowMs(), std::memory_order_relaxed);
-        if (g_state.load() != GameState::InGame) {
-            g_state.store(GameState::InGame);
-            _LOGD("[FSM] -> InGame (hands ticking)");
-            // replay last trigger settings here
-            sendAdaptiveTriggersForCurrentWeapon();
-        }
-    }
-    return;
-}
-
-
-static void MenuPauseWatcher() {
- const uint64_t THRESHOLD_MS = 350;
-    for (;;) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(75));
-        if (g_state.load(std::memory_order_relaxed) == GameState::Idle)
-            continue;
-
-        const uint64_t last = g_lastHandsBeat.load(std::memory_order_relaxed);
-        const uint64_t age  = NowMs() - last;
-
-        // purely heartbeat-based pause detection
-        if (age > THRESHOLD_MS) {
-            if (g_state.load(std::memory_order_relaxed) != GameState::Paused) {
-                g_state.store(GameState::Paused, std::memory_order_relaxed);
-                _LOGD("[FSM] -> Paused (hands stalled %.0f ms)", double(age));
-                resetAdaptiveTriggers();
-            }
-        }
-        // Resume is handled in idHandsUpdate_Hook when it ticks again.
-    }
-}
-
-// optional global flag for your mod
-static std::atomic<bool> g_PlayerDead{false};
-// reentrancy + once-only flag
-static thread_local bool g_inDamage = false;
-static std::atomic<bool> g_pendingDeath{false};
-
-
-static inline bool CallIsDead(void* player)
-{
-    if (!player) return false;
-    void** vtbl = *reinterpret_cast<void***>(player);
-    if (!vtbl) return false;
-    // index (not byte offset)
-    auto IsDeadFn = reinterpret_cast<_IsDead>(vtbl[0x6C8 / 8]);
-    return IsDeadFn ? IsDeadFn(player) : false;
-}
-
-void Damage_Hook(
-    void* player,
-    void* inflictor,
-    void* attacker,
-    long long damageDecl,
-    float damageScale,
-    const float* dir,
-    const float* hitInfo)
-{
-    if (g_inDamage) {
-        Damage_Original (
-                player, inflictor, attacker, damageDecl, damageScale,
-                dir, hitInfo
-        );
-        return;
-    }
-
-    g_inDamage = true;
-
-    // let the game apply damage
-    Damage_Original (
-            player, inflictor, attacker, damageDecl, damageScale,
-            dir, hitInfo
-    );
-
-    if (player == g_currPlayer) {
-        // state after damage
-        const bool isDead = CallIsDead(player);
-
-        if (isDead)
-        {
-            g_state.store(GameState::Idle, std::memory_order_release);
-            g_lastHandsBeat.store(NowMs(), std::memory_order_relaxed);
-            resetAdaptiveTriggers();
-            g_currWeapon = nullptr;
-            g_HasAmmo.clear(); // reset ammo info
-            resetAmmoPtrs();
-            _LOGD("* Damage hook, Player is DEAD! Switching to Idle state...");
-        }
-    }
-    g_inDamage = false;
-}
-
-unsigned long long SelectWeaponByDeclExplicit_Hook(long long *player,
-                            long long decl, char param_3, char param_4) {
-    _LOGD("* idPlayer::SelectWeaponByDeclExplicit hook!!!");
-
-    Weapon *weapon = nullptr;
-    if (long long *mgr = (long long *) GetWeaponMgr(player)) {
-        weapon = (Weapon *)GetWeaponFromDecl(mgr, decl);
-        if (weapon) {
-            const char* name = GetWeaponName (
-                    reinterpret_cast<long long*>(weapon)
-            );
-            if (name && name[0]) {
-                _LOGD("* (init) curr weapon: %s", name);
-            }
-            g_currWeapon = weapon;
+#define HOOK_ENTRY(fn) { #fn, (LPVOID) fn.GetUIntPtr(), \
+        (LPVOID) Hooks::fn##_Hook, \
+        reinterpret_cast<LPVOID *>(&Hooks::fn##_Original) }
+
+    // Removes the hooks created so far; none of them is left enabled
+    static void rollbackHooks(const HookEntry *hooks, size_t created) {
+        // one thread freeze for all; removing a disabled hook needs none
+        MH_DisableHook(MH_ALL_HOOKS);
+        for (size_t i = 0; i < created; i++) {
+            MH_RemoveHook(hooks[i].target);
+            *hooks[i].original = nullptr;
         }
     }
-    unsigned long long ret = SelectWeaponByDeclExplicit_Original (
-            player, decl, param_3, param_4
-    );
-
-    // reset player here (paused used for loading the latest checkpoint
-    // from the main menu)
-    if (g_currPlayer && (g_state == GameState::Idle ||
-                g_state == GameState::Paused)) {
-        g_state.store(GameState::Idle, std::memory_order_release);
-        g_currPlayer = nullptr;
-    }
-    return ret;
-}
-
-    // util
-
-    static inline uint64_t NowMs() {
-        using namespace std::chrono;
-        return duration_cast<milliseconds> (
-                steady_clock::now().time_since_epoch()
-        ).count();
-    }
-
-    void LevelLoadCompleted_Hook (long long *this_idLoadScreen) {
-        _LOGD("idLoadScreen::LevelLoadCompleted hook!");
-
-        LevelLoadCompleted_Original(this_idLoadScreen);
-        if (g_currPlayer && g_state == GameState::Paused) {
-            g_state.store(GameState::Idle, std::memory_order_release);
-            resetAdaptiveTriggers();
-            g_currWeapon = nullptr;
-            g_lastHandsBeat.store(NowMs(), std::memory_order_relaxed);
-            //g_HasAmmo.clear(); // reset ammo info
-            //resetAmmoPtrs();
-            _LOGD("* Exiting to main menu! Switching to Idle state...");
-            return;
-        }
-        if (g_currPlayer && g_state == GameState::Idle) {
-            g_state.store(GameState::InGame, std::memory_order_release);
-            Weapon* weapon = GetCurrentWeaponAlter(g_currPlayer);
-            if (weapon) {
-                const char* name = GetWeaponName (
-                        reinterpret_cast<long long*>(weapon)
-                );
-                if (name && name[0]) {
-                    g_currWeapon = weapon;
-                    bool hasAmmo = HasAmmo(name);
-                    _LOGD (
-                            "* curr weapon = %s, hasAmmo: %s\n",
-                            name, hasAmmo ? "true" : "false"
-                    );
-
-                }
-                // enable triggers
-                sendAdaptiveTriggersForCurrentWeapon();
-            } else {
-                    _LOGD("* curr weapon: (not found!)");
-            }
-        }
-        return;
-    }
 
+    // Every MH_EnableHook suspends and resumes all of the game's threads,
+    // so the hooks are created first, queued, and enabled together with a
+    // single MH_ApplyQueued. Either all of them go live or none does.
     bool ApplyHooks() {
         _LOG("Applying hooks...");
-        // Hook loadout type registration to obtain pointer to the model handle
-        MH_Initialize();
-
-        MH_CreateHook (
-            OnWeaponSelected,
-            OnWeaponSelected_Hook,
-            reinterpret_cast<LPVOID *>(&OnWeaponSelected_Original)
-        );
-        if (MH_EnableHook(OnWeaponSelected) != MH_OK) {
-            _LOG("FATAL: Failed to install OnWeaponSelected hook.");
-            return false;
-        }
-
-        MH_CreateHook (
-            SelectWeaponByDeclExplicit,
-            SelectWeaponByDeclExplicit_Hook,
-            reinterpret_cast<LPVOID *>(&SelectWeaponByDeclExplicit_Original)
-        );
-        if (MH_EnableHook(SelectWeaponByDeclExplicit) != MH_OK) {
-            _LOG("FATAL: Failed to install SelectWeaponByDeclExplicit hook.");
+        const HookEntry hooks[] = {
+            HOOK_ENTRY(OnWeaponSelected),
+            HOOK_ENTRY(SelectWeaponByDeclExplicit),
+            HOOK_ENTRY(UpdateWeapon),
+            HOOK_ENTRY(UpdateAmmo),
+            HOOK_ENTRY(SetFireMode),
+            HOOK_ENTRY(idHandsUpdate),
+            HOOK_ENTRY(Damage),
+            HOOK_ENTRY(LevelLoadCompleted),
+        };
+        constexpr size_t count = sizeof(hooks) / sizeof(hooks[0]);
+
+        MH_STATUS status = MH_Initialize();
+        if (status != MH_OK && status != MH_ERROR_ALREADY_INITIALIZED) {
+            _LOGW(LOG_HOOKS, "FATAL: MinHook init failed: %s",
+                    MH_StatusToString(status));
             return false;
         }
 
-        MH_CreateHook (
-            UpdateWeapon,
-            UpdateWeapon_Hook,
-            reinterpret_cast<LPVOID *>(&UpdateWeapon_Original)
-        );
-        if (MH_EnableHook(UpdateWeapon) != MH_OK) {
-            _LOG("FATAL: Failed to install UpdateWeapon hook.");
-            return false;
-        }
-        MH_CreateHook (
-            UpdateAmmo,
-            UpdateAmmo_Hook,
-            reinterpret_cast<LPVOID *>(&UpdateAmmo_Original)
-        );
-        if (MH_EnableHook(UpdateAmmo) != MH_OK) {
-            _LOG("FATAL: Failed to install UpdateAmmo hook.");
-            return false;
-        }
-
-        MH_CreateHook (
-            SetFireMode,
-            SetFireMode_Hook,
-            reinterpret_cast<LPVOID *>(&SetFireMode_Original)
-        );
-        if (MH_EnableHook(SetFireMode) != MH_OK) {
-            _LOG("FATAL: Failed to install SetFireMode hook.");
-            return false;
-        }
-        MH_CreateHook (
-            idHandsUpdate,
-            idHandsUpdate_Hook,
-            reinterpret_cast<LPVOID *>(&idHandsUpdate_Original)
-        );
-        if (MH_EnableHook(idHandsUpdate) != MH_OK) {
-            _LOG("FATAL: Failed to install idHandsUpdate hook.");
-            return false;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            status = MH_CreateHook(hooks[i].target, hooks[i].detour,
+                    hooks[i].original);
+            if (status != MH_OK) {
+                _LOGW(LOG_HOOKS, "FATAL: Failed to create %s hook: %s",
+                        hooks[i].name, MH_StatusToString(status));
+                rollbackHooks(hooks, i);
+                return false;
+            }
         }
-        MH_CreateHook (
-            Damage,
-            Damage_Hook,
-            reinterpret_cast<LPVOID *>(&Damage_Original)
-        );
-        if (MH_EnableHook(Damage) != MH_OK) {
-            _LOG("FATAL: Failed to install Damage hook.");
-            return false;
+        const double createMs = sinceMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            status = MH_QueueEnableHook(hooks[i].target);
+            if (status != MH_OK) {
+                _LOGW(LOG_HOOKS, "FATAL: Failed to queue %s hook: %s",
+                        hooks[i].name, MH_StatusToString(status));
+                rollbackHooks(hooks, count);
+                return false;
+            }
         }
-        MH_CreateHook (
-            LevelLoadCompleted,
-            LevelLoadCompleted_Hook,
-            reinterpret_cast<LPVOID *>(&LevelLoadCompleted_Original)
-        );
-        if (MH_EnableHook(LevelLoadCompleted) != MH_OK) {
-            _LOG("FATAL: Failed to install LevelLoadCompleted hook.");
+        const double queueMs = sinceMs(start);
+
+        start = std::chrono::steady_clock::now();
+        status = MH_ApplyQueued();
+        const double applyMs = sinceMs(start);
+        if (status != MH_OK) {
+            _LOGW(LOG_HOOKS, "FATAL: Failed to enable the hooks: %s",
+                    MH_StatusToString(status));
+            rollbackHooks(hooks, count);
             return false;
         }
-        _LOG("Hooks applied successfully!");
 
+        _LOG("Hooks applied successfully! (%zu hooks; create: %.3f ms, "
+                "queue: %.3f ms, apply: %.3f ms)",
+                count, createMs, queueMs, applyMs);
         return true;
     }
 
+#undef HOOK_ENTRY
+
     bool InitAddresses() {
-        _LOG("Sigscan start");
+        _LOGI(LOG_SIGSCAN, "Sigscan start");
         RVAUtils::Timer tmr; tmr.start();
         RVAManager::UpdateAddresses(0);
-        _LOG("Sigscan elapsed: %llu ms.", tmr.stop());
+        _LOGI(LOG_SIGSCAN, "Sigscan elapsed: %llu ms.", tmr.stop());
 
         // Check if all addresses were resolved
         for (auto rvaData : RVAManager::GetAllRVAs()) {
             if (!rvaData->effectiveAddress) {
-                _LOG("Signature: %s was not resolved!", rvaData->sig);
+                _LOGW(LOG_SIGSCAN, "Signature: %s was not resolved!", rvaData->sig);
             }
         }
         if (!RVAManager::IsAllResolved())
@@ -1286,7 +885,51 @@ std::string wstring_to_utf8(const std::wstring& ws) {
     constexpr int MAX_ATTEMPTS = 5;
     constexpr int RETRY_DELAY_MS = 2000;
 
+    // Scheduler task: connects the client to the service, retrying with
+    // exponential backoff (up to RETRY_DELAY_MS) while it isn't up yet
+    void connectClient(int attempt) {
+        _LOG("Client starting DualSensitive Service...\n");
+        const auto start = std::chrono::steady_clock::now();
+        auto status = dualsensitive::init (
+                AgentMode::CLIENT,
+                "./mods/duaslensitive-client.log",
+                g_config.isDebugMode
+        );
+        if (status != dualsensitive::Status::Ok) {
+            _LOG(
+                "Failed to initialize DualSensitive in CLIENT mode, "
+                "status: %d (attempt %d/%d)",
+                static_cast<
+                    std::underlying_type<
+                        dualsensitive::Status>::type>(status),
+                attempt, MAX_ATTEMPTS
+            );
+            if (attempt < MAX_ATTEMPTS) {
+                const int delayMs =
+                    std::min(RETRY_DELAY_MS, 250 << (attempt - 1));
+                Scheduler::After(std::chrono::milliseconds(delayMs),
+                        [attempt] { connectClient(attempt + 1); });
+                return;
+            }
+            _LOGW(LOG_TRANSPORT, "DualSensitive Service unreachable after %d "
+                    "attempts (%.1f ms after init); triggers stay off",
+                    MAX_ATTEMPTS, sinceInitMs());
+            return;
+        }
+        _LOG("DualSensitive Service launched successfully...\n");
+        dualsensitive::sendPidToServer();
+        // the hooks may have been sending before the client was up
+        g_dualSensitiveSink.Forget();
+        Pipeline::Resend();
+        _LOG("[Startup] client init: %.1f ms; triggers live %.1f ms "
+                "after init", sinceMs(start), sinceInitMs());
+    }
+
     void Init() {
+        g_initStart = std::chrono::steady_clock::now();
+        // the mod's background thread: log flushing, pause watching, service
+        // startup and stats all run on it
+        Scheduler::Start();
         g_logger.Open("./mods/dualsensemod.log");
         _LOG(
             "DOOM (2016) DualsenseMod v1.2 by Thanos Petsas (SkyExplosionist)");
@@ -1302,7 +945,7 @@ std::string wstring_to_utf8(const std::wstring& ws) {
                 "DualsenseMod",
                 MB_OK | MB_ICONEXCLAMATION
             );
-            _LOG("FATAL: Incompatible version");
+            _LOGW(LOG_SIGSCAN, "FATAL: Incompatible version");
             return;
         }
 
@@ -1312,58 +955,73 @@ std::string wstring_to_utf8(const std::wstring& ws) {
         g_config = Config(INI_LOCATION);
         g_config.print();
 
-        InitTriggerSettings();
+        if (g_config.isTraceMode) {
+            if (Trace::Open(TRACE_LOCATION)) {
+                _LOG("Binary trace enabled: %s", TRACE_LOCATION);
+            } else {
+                _LOG("Failed to open %s; trace mode disabled", TRACE_LOCATION);
+                g_config.isTraceMode = false;
+            }
+        }
 
-        ApplyHooks();
+        if (g_config.isTimelineMode) {
+            Timeline::Enable();
+            _LOG("Timeline enabled: %s", TIMELINE_LOCATION);
+        }
 
-        CreateThread(nullptr, 0, [](LPVOID) -> DWORD {
-            _LOG("Client starting DualSensitive Service...\n");
-            if (!launchServerTaskOrElevated()) {
-                _LOG("Error launching the DualSensitive Service...\n");
-                return 1;
+        if (g_config.isRecordMode) {
+            if (Recorder::Open(RECORD_LOCATION)) {
+                _LOG("Recording session events: %s", RECORD_LOCATION);
+            } else {
+                _LOG("Failed to open %s; recording disabled", RECORD_LOCATION);
+                g_config.isRecordMode = false;
             }
-            g_serverLaunchMutex.lock();
-            g_serverStarted = true;
-            g_serverLaunchMutex.unlock();
-            _LOG("DualSensitive Service launched successfully...\n");
-            return 0;
-        }, nullptr, 0, nullptr);
-
-
-        CreateThread(nullptr, 0, [](LPVOID) -> DWORD {
-            // wait for server to start first
-            do {
-                g_serverLaunchMutex.lock();
-                bool started = g_serverStarted;
-                g_serverLaunchMutex.unlock();
-                if (started) break;
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-            } while (true);
+        }
+
+        // the current weapon is sent again as soon as its profile changes
+        TriggerProfiles::Start(PROFILES_LOCATION, DefaultTriggerSettings(),
+                ResolveTrigger, Pipeline::Resend,
+                std::chrono::milliseconds(250));
+        Pipeline::SetSink(&g_dualSensitiveSink);
+        Pipeline::SetOutputRate(g_config.triggerRateHz, 4);
 
+        // the hooks check the object field offsets against the game, and
+        // look for them again if this version moved them
+        Offsets::Load(OFFSETS_LOCATION, Utils::GetGameVersion());
+
+        if (!ApplyHooks()) {
+            // nothing is hooked: the triggers would never change
+            _LOGW(LOG_HOOKS, "FATAL: Hooks not applied; the mod is disabled");
+            return;
+        }
+
+        // schtasks (up to two 10 s waits) or the UAC prompt can take a
+        // while, and the scheduler is already flushing the log and watching
+        // for pauses: launch from a thread of its own, then connect from the
+        // scheduler as usual
+        std::thread([] {
             _LOG("Client starting DualSensitive Service...\n");
-            auto status = dualsensitive::init (
-                    AgentMode::CLIENT,
-                    "./mods/duaslensitive-client.log",
-                    g_config.isDebugMode
-            );
-            if (status != dualsensitive::Status::Ok) {
-                _LOG(
-                    "Failed to initialize DualSensitive in CLIENT mode, "
-                    "status: %d",
-                    static_cast<
-                        std::underlying_type<
-                            dualsensitive::Status>::type>(status)
-                );
+            const auto start = std::chrono::steady_clock::now();
+            const bool launched = launchServerTaskOrElevated();
+            if (launched) {
+                _LOG("DualSensitive Service launched successfully...\n");
+            } else {
+                // the service may still have been started by hand
+                _LOGW(LOG_TRANSPORT, "Error launching the DualSensitive Service...\n");
             }
-            _LOG("DualSensitive Service launched successfully...\n");
-            dualsensitive::sendPidToServer();
-            return 0;
-        }, nullptr, 0, nullptr);
-
-        std::thread([]{
-            MenuPauseWatcher();
+            _LOG("[Startup] service launch: %.1f ms (%.1f ms since init)",
+                    sinceMs(start), sinceInitMs());
+            Scheduler::After(std::chrono::milliseconds(0),
+                    [] { connectClient(1); });
         }).detach();
 
+        FSM::StartPauseWatcher(g_config.pauseThresholdMs, onGamePaused);
+
+        if (g_config.statsIntervalSec) {
+            Scheduler::Every(std::chrono::seconds(g_config.statsIntervalSec),
+                    HookStats::Dump);
+        }
+
         _LOG("Ready.");
     }
 }
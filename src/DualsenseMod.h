@@ -5,6 +5,8 @@
 
 #pragma once
 
+#define TIMELINE_LOCATION "./mods/dualsensemod.timeline.json"
+
 namespace DualsenseMod {
     void Init();
 }
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "GameHooks.h"
+#include "HookStats.h"
+#include "Logger.h"
+#include "Memory.h"
+#include "Offsets.h"
+#include "Pipeline.h"
+#include "Timeline.h"
+#include "WeaponCache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Hooks {
+    _HandleToPointer HandleToPointer = nullptr;
+    _GetWeaponFromDecl GetWeaponFromDecl = nullptr;
+
+    _OnWeaponSelected OnWeaponSelected_Original = nullptr;
+    _SelectWeaponByDeclExplicit SelectWeaponByDeclExplicit_Original = nullptr;
+    _LevelLoadCompleted LevelLoadCompleted_Original = nullptr;
+    _Damage Damage_Original = nullptr;
+    _UpdateWeapon UpdateWeapon_Original = nullptr;
+    _UpdateAmmo UpdateAmmo_Original = nullptr;
+    _SetFireMode SetFireMode_Original = nullptr;
+    _idHandsUpdate idHandsUpdate_Original = nullptr;
+}
+
+using namespace Hooks;
+
+// Utility functions
+
+using GetMgr_t = void* (__fastcall*)(Player* player);
+inline void* GetWeaponMgr(Player* player) {
+    auto vtbl = *reinterpret_cast<void***>(player);
+    auto fn   = reinterpret_cast<GetMgr_t>(vtbl[kGetWeaponMgrSlot/8]);
+    return fn(player);
+}
+
+static inline uint32_t GetPlayerState(Player* player) {
+    auto vtable = *reinterpret_cast<void***>(player);
+    return reinterpret_cast<PlayerState>(vtable[kPlayerStateSlot/8])(player);
+}
+
+static inline uint64_t GetPlayerHandle(Player* player, uint32_t state) {
+    auto vtable = *reinterpret_cast<void***>(player);
+    return reinterpret_cast<GetHandle>(vtable[kGetHandleSlot/8])(player, state);
+}
+
+static inline char *GetWeaponName(long long* weapon) {
+    if (!weapon) return nullptr;
+    return (char *)(*(long long *)(weapon[6] + 8));
+}
+
+// Reports the handle the player gives for its current weapon, until the
+// offset we read it from has been checked (see Offsets.h)
+static void ObserveCurrWeaponHandle(Player *player) {
+    if (!player || !Offsets::Checking(Offsets::PlayerWeaponHandle))
+        return;
+    const uint64_t handle = GetPlayerHandle(player, GetPlayerState(player));
+    if (handle)
+        Offsets::ObserveValue(Offsets::PlayerWeaponHandle, player, handle);
+}
+
+static WeaponCache::Entry GetCurrentWeaponAlter (Player *player) {
+    uint64_t h2  = *(uint64_t*)((uint8_t*)player +
+            Offsets::Get(Offsets::PlayerWeaponHandle));
+    void*    p2  = HandleToPointer(h2);
+    return { p2, GetWeaponName(reinterpret_cast<long long*>(p2)) };
+}
+
+// idPlayer's weapon for decl, as the game's SelectWeaponByDeclExplicit will
+// find it
+static WeaponCache::Entry GetWeaponByDecl(Player *player, long long decl) {
+    WeaponCache::Entry cached;
+    if (WeaponCache::FindByDecl(player, decl, cached))
+        return cached;
+    if (long long *mgr = (long long *) GetWeaponMgr(player)) {
+        Weapon *weapon = (Weapon *)GetWeaponFromDecl(mgr, decl);
+        cached = { weapon, GetWeaponName(reinterpret_cast<long long*>(weapon)) };
+    }
+    WeaponCache::StoreByDecl(player, decl, cached);
+    return cached;
+}
+
+[[maybe_unused]] static inline Weapon *GetCurrentWeapon (Player *player) {
+    if (!player || !HandleToPointer) {
+        _LOGD(LOG_HOOKS, "Player or HandleToPointer is NULL");
+        return nullptr;
+    }
+
+    // read 64-bit handle the engine stores in idPlayer
+    const auto handle = *reinterpret_cast <const uint64_t *> (
+        reinterpret_cast <const uint8_t *> (player) +
+            Offsets::Get(Offsets::PlayerWeaponHandle)
+    );
+
+    if (!handle) {
+        _LOGD(LOG_HOOKS, "Player handle is NULL");
+        return nullptr;
+    }
+
+    return HandleToPointer(handle);
+}
+
+enum TriggerState : int { TS_Idle=0, TS_Pressed=1, TS_Held=2, TS_Released=3};
+
+// Virtual: bool idPlayer::IsDead() const;
+static inline bool CallIsDead(void* player)
+{
+    if (!player) return false;
+    void** vtbl = *reinterpret_cast<void***>(player);
+    if (!vtbl) return false;
+    // index (not byte offset)
+    auto IsDeadFn = reinterpret_cast<_IsDead>(vtbl[kIsDeadSlot / 8]);
+    return IsDeadFn ? IsDeadFn(player) : false;
+}
+
+// reentrancy + once-only flag
+static thread_local bool g_inDamage = false;
+
+namespace Hooks {
+
+    void OnWeaponSelected_Hook(void *player, long long *weapon) {
+        HOOK_TIMER(HookId::OnWeaponSelected);
+        _LOGD(LOG_HOOKS, "* OnWeaponSelected hook!!!");
+
+        if (weapon == nullptr) {
+            HOOK_ORIGINAL(OnWeaponSelected_Original(player, weapon));
+            return;
+        }
+
+        Pipeline::OnWeaponSelected(weapon, GetWeaponName(weapon));
+        HOOK_ORIGINAL(OnWeaponSelected_Original(player, weapon));
+        return;
+    }
+
+    void UpdateWeapon_Hook (void *player) {
+        HOOK_TIMER(HookId::UpdateWeapon);
+
+        Pipeline::OnUpdateWeapon(player);
+
+        HOOK_ORIGINAL(UpdateWeapon_Original(player));
+        ObserveCurrWeaponHandle((Player *) player);
+        return;
+    }
+
+    int UpdateAmmo_Hook (void *ammo, int delta, char clamp) {
+        HOOK_TIMER(HookId::UpdateAmmo);
+        // a clamped update may not move the count by delta
+        uint8_t before[Offsets::kAmmoSnapshotSize];
+        size_t snapshot = 0;
+        if (ammo && delta && !clamp && Offsets::Checking(Offsets::AmmoCount)) {
+            snapshot = Memory::ReadableSpan((uintptr_t)ammo, sizeof(before));
+            memcpy(before, ammo, snapshot);
+        }
+        int ret = HOOK_ORIGINAL(UpdateAmmo_Original(ammo, delta, clamp));
+        if (!ammo)
+            return ret;
+        if (snapshot) {
+            Offsets::ObserveDelta(Offsets::AmmoCount, ammo, before, snapshot,
+                    delta);
+        }
+        int* pCount = (int*)((uint8_t*)ammo + Offsets::Get(Offsets::AmmoCount));
+        int  count  = *pCount;
+        _LOGT(LOG_AMMO, "* UpdateAmmo hook! ammo ptr: %p, delta: %d, clamp: %d, AMMO: %d",
+                ammo,
+                delta,
+                clamp,
+                count
+        );
+
+        Pipeline::OnAmmoUpdate(ammo, count);
+        return ret;
+    }
+
+    bool SetFireMode_Hook(void* weapon, uint32_t mode, char allowSame) {
+        HOOK_TIMER(HookId::SetFireMode);
+        // This tells us if mod is active (i.e., if left trigger is pressed)
+        // XXX NOTE: we should check allowSame and other fields based on the
+        // Ghidra source as we might discover which mode is active, if the gun
+        // can still fire or if the mod is in charging state, etc.
+        bool ok = HOOK_ORIGINAL(SetFireMode_Original(weapon, mode, allowSame));
+        Pipeline::OnFireModeSet(ok, mode);
+        return ok;
+    }
+
+    void idHandsUpdate_Hook(void *self, void * state) {
+        HOOK_TIMER(HookId::idHandsUpdate);
+        static bool namedThread = (Timeline::NameThread("game"), true);
+        (void)namedThread;
+        HOOK_ORIGINAL(idHandsUpdate_Original(self, state));
+        Pipeline::OnHandsTick();
+        return;
+    }
+
+    void Damage_Hook(
+        void* player,
+        void* inflictor,
+        void* attacker,
+        long long damageDecl,
+        float damageScale,
+        const float* dir,
+        const float* hitInfo)
+    {
+        HOOK_TIMER(HookId::Damage);
+        if (g_inDamage) {
+            HOOK_ORIGINAL(Damage_Original (
+                    player, inflictor, attacker, damageDecl, damageScale,
+                    dir, hitInfo
+            ));
+            return;
+        }
+
+        g_inDamage = true;
+
+        // let the game apply damage
+        HOOK_ORIGINAL(Damage_Original (
+                player, inflictor, attacker, damageDecl, damageScale,
+                dir, hitInfo
+        ));
+
+        if (Pipeline::IsCurrentPlayer(player)) {
+            // state after damage
+            const bool isDead = CallIsDead(player);
+            if (isDead)
+                WeaponCache::Invalidate();
+            Pipeline::OnPlayerDamaged(isDead);
+        }
+        g_inDamage = false;
+    }
+
+    unsigned long long SelectWeaponByDeclExplicit_Hook(long long *player,
+                                long long decl, char param_3, char param_4) {
+        HOOK_TIMER(HookId::SelectWeaponByDeclExplicit);
+        _LOGD(LOG_HOOKS, "* idPlayer::SelectWeaponByDeclExplicit hook!!!");
+
+        const WeaponCache::Entry weapon = GetWeaponByDecl(player, decl);
+        Pipeline::OnSelectWeaponByDecl(weapon.weapon, weapon.name);
+        unsigned long long ret = HOOK_ORIGINAL(SelectWeaponByDeclExplicit_Original (
+                player, decl, param_3, param_4
+        ));
+        Pipeline::OnSelectWeaponByDeclDone();
+        return ret;
+    }
+
+    void LevelLoadCompleted_Hook (long long *this_idLoadScreen) {
+        HOOK_TIMER(HookId::LevelLoadCompleted);
+        _LOGD(LOG_HOOKS, "idLoadScreen::LevelLoadCompleted hook!");
+
+        HOOK_ORIGINAL(LevelLoadCompleted_Original(this_idLoadScreen));
+        // a new level (or checkpoint) comes with a new inventory
+        WeaponCache::Invalidate();
+        if (Pipeline::OnLevelLoaded()) {
+            const WeaponCache::Entry weapon = GetCurrentWeaponAlter (
+                    (Player *) Pipeline::CurrentPlayer()
+            );
+            Pipeline::OnLevelStartWeapon(weapon.weapon, weapon.name);
+        }
+        return;
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef _WIN32
+// host builds (tools/hook-bench): x64 has a single calling convention
+#define __fastcall
+#endif
+
+// Game structures
+using Player  = void;
+using Weapon  = void;
+
+// Game functions
+using _OnWeaponSelected =
+                    void(__fastcall*)(void *player, long long *weapon);
+
+using _SelectWeaponByDeclExplicit =
+                    unsigned long long(__fastcall*) (
+                            long long *player, long long param_2,
+                            char param_3, char param_4
+                    );
+
+using _UpdateWeapon =
+                    void(__fastcall*) (void *player);
+
+
+using _Damage = void(__fastcall*)(
+    void* player,
+    void* inflictor,
+    void* attacker,
+    long long damageDecl,
+    float damageScale,
+    const float* dir,
+    const float* hitInfo
+);
+
+// Virtual: bool idPlayer::IsDead() const;
+// found at vtable + 0x6C8
+using _IsDead = bool(__fastcall*)(void* player);
+
+using _LevelLoadCompleted =
+                    void (__fastcall*)(long long *this_idLoadScreen);
+
+
+using _UpdateAmmo =
+                    int (__fastcall *)(void *ammo, int delta, char clamp);
+
+
+using _GetWeaponFromDecl =
+                    void* (__fastcall*)(long long* mgr, long long decl);
+
+using _SetFireMode =
+                    bool(__fastcall*) (
+                            void* weapon, uint32_t mode, char allowSame
+                    );
+
+using _idMenuManagerShell_Activate =
+                    void (__fastcall *)(void *self, uint32_t stateId);
+
+using _idHandsUpdate =
+                    void(__fastcall*) (void *self, void *state);
+
+// handle to pointer resolution. It takes a 64-bit handle/id and returns a real
+// object pointer (FUN_14142C870 for Vulkan and FUN_14142c7d0 for OpenGL)
+using _HandleToPointer  = Weapon* (__fastcall*)(uint64_t);
+
+// idPlayer's vtable + 0xB20
+using PlayerState  = uint32_t(__fastcall*)(Player*);
+
+// idPlayer's vtable +0x678
+using GetHandle    = uint64_t(__fastcall*)(Player*, uint32_t state);
+
+// The detours installed by ApplyHooks and the game accessors they use.
+//
+// They only read the game objects they're handed (through the layouts
+// below) and report to the Pipeline, so they build on the host as well,
+// where tools/hook-bench runs them against fabricated objects.
+namespace Hooks {
+    // game functions the hooks call; resolved by sigscan
+    extern _HandleToPointer HandleToPointer;
+    extern _GetWeaponFromDecl GetWeaponFromDecl;
+
+    // trampolines to the game's functions; filled in by MH_CreateHook
+    extern _OnWeaponSelected OnWeaponSelected_Original;
+    extern _SelectWeaponByDeclExplicit SelectWeaponByDeclExplicit_Original;
+    extern _LevelLoadCompleted LevelLoadCompleted_Original;
+    extern _Damage Damage_Original;
+    extern _UpdateWeapon UpdateWeapon_Original;
+    extern _UpdateAmmo UpdateAmmo_Original;
+    extern _SetFireMode SetFireMode_Original;
+    extern _idHandsUpdate idHandsUpdate_Original;
+
+    // Game object layouts; the field offsets are only where Offsets (see
+    // Offsets.h) starts looking
+    // idPlayer: current weapon handle
+    constexpr size_t kCurrWeaponHandleOffset = 0x9788;
+    // idInventoryItem_Ammo: count
+    constexpr unsigned int kAmmoCountOffset = 0x38;
+    // idPlayer vtable slots (byte offsets)
+    constexpr unsigned int kGetWeaponMgrSlot = 0x660;
+    constexpr unsigned int kGetHandleSlot = 0x678;
+    constexpr unsigned int kIsDeadSlot = 0x6C8;
+    constexpr unsigned int kPlayerStateSlot = 0xB20;
+
+    void OnWeaponSelected_Hook(void *player, long long *weapon);
+    unsigned long long SelectWeaponByDeclExplicit_Hook(long long *player,
+            long long decl, char param_3, char param_4);
+    void UpdateWeapon_Hook(void *player);
+    int UpdateAmmo_Hook(void *ammo, int delta, char clamp);
+    bool SetFireMode_Hook(void *weapon, uint32_t mode, char allowSame);
+    void idHandsUpdate_Hook(void *self, void *state);
+    void Damage_Hook(void *player, void *inflictor, void *attacker,
+            long long damageDecl, float damageScale, const float *dir,
+            const float *hitInfo);
+    void LevelLoadCompleted_Hook(long long *this_idLoadScreen);
+}
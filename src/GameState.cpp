@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "GameState.h"
+#include "Logger.h"
+#include "Scheduler.h"
+#include "Timeline.h"
+#include "Tsc.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<GameState> g_state{GameState::Idle};
+
+// when idHandsUpdate last ticked (Tsc); the hook only stores this, the
+// watcher reads it
+static std::atomic<uint64_t> g_lastBeat{0};
+
+static std::mutex g_watcherMutex;
+static Clock::duration g_pauseThreshold = std::chrono::milliseconds(350);
+static FSM::PauseCallback g_onPause = nullptr;
+static bool g_watcherStarted = false;
+static double g_ticksPerUs = 1.0;
+
+// guarded by g_watcherMutex: the watcher's next check, pending while in
+// gameplay
+static Scheduler::TaskId g_sampleTask = 0;
+static FSM::WatcherStats g_watcherStats;
+
+static void SamplePauseWatcher();
+
+// called with g_watcherMutex held; entering InGame counts as a fresh
+// heartbeat
+static void ArmPauseWatcher() {
+    g_lastBeat.store(Tsc::Now(), std::memory_order_relaxed);
+    if (!g_sampleTask)
+        g_sampleTask = Scheduler::After(g_pauseThreshold, SamplePauseWatcher);
+}
+
+// The heartbeat doesn't notify anyone; while in gameplay this runs on the
+// scheduler once the threshold has passed since the last tick it knows of.
+// If the game ticked since, it goes back to sleep until the threshold has
+// passed since that tick; otherwise the game has been still for exactly the
+// threshold. Outside of gameplay it isn't scheduled at all.
+static void SamplePauseWatcher() {
+    std::unique_lock<std::mutex> lock(g_watcherMutex);
+    g_watcherStats.wakeups++;
+    g_sampleTask = 0;
+    // nothing to watch; the next transition to InGame re-arms us
+    if (!g_watcherStarted ||
+            g_state.load(std::memory_order_relaxed) != GameState::InGame)
+        return;
+
+    const uint64_t beat = g_lastBeat.load(std::memory_order_relaxed);
+    const uint64_t now = Tsc::Now();
+    const auto still = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(
+                now > beat ? (now - beat) / g_ticksPerUs : 0));
+    if (still < g_pauseThreshold) {
+        g_sampleTask = Scheduler::After(g_pauseThreshold - still,
+                SamplePauseWatcher);
+        return;
+    }
+
+    GameState expected = GameState::InGame;
+    if (!g_state.compare_exchange_strong(expected, GameState::Paused))
+        return;
+
+    Timeline::Instant("fsm", "Paused");
+    const double latencyMs =
+        std::chrono::duration<double, std::milli>(still).count();
+    g_watcherStats.pauses++;
+    g_watcherStats.lastLatencyMs = latencyMs;
+    g_watcherStats.totalLatencyMs += latencyMs;
+    if (latencyMs > g_watcherStats.maxLatencyMs)
+        g_watcherStats.maxLatencyMs = latencyMs;
+    const FSM::WatcherStats stats = g_watcherStats;
+    FSM::PauseCallback onPause = g_onPause;
+    lock.unlock();
+
+    _LOGD(LOG_FSM, "[FSM] -> Paused (hands stalled %.1f ms; pauses: %llu, "
+            "avg: %.1f ms, max: %.1f ms)",
+            latencyMs,
+            (unsigned long long) stats.pauses,
+            stats.totalLatencyMs / stats.pauses,
+            stats.maxLatencyMs
+    );
+    if (onPause)
+        onPause();
+}
+
+namespace FSM {
+
+    GameState Get() {
+        return g_state.load(std::memory_order_acquire);
+    }
+
+    void Set(GameState state) {
+        {
+            // taking the lock orders this against the sampling task's own
+            // InGame -> Paused transition
+            std::lock_guard<std::mutex> lock(g_watcherMutex);
+            g_state.store(state, std::memory_order_release);
+            if (state == GameState::InGame && g_watcherStarted)
+                ArmPauseWatcher();
+        }
+        Timeline::Instant("fsm", ToString(state));
+    }
+
+    const char *ToString(GameState state) {
+        switch (state) {
+            case GameState::Idle:   return "Idle";
+            case GameState::InGame: return "InGame";
+            case GameState::Paused: return "Paused";
+            default:                return "Unknown";
+        }
+    }
+
+    bool Heartbeat() {
+        g_lastBeat.store(Tsc::Now(), std::memory_order_relaxed);
+        if (g_state.load(std::memory_order_relaxed) == GameState::InGame)
+            return false;
+        Set(GameState::InGame);
+        return true;
+    }
+
+    void StartPauseWatcher(uint64_t thresholdMs, PauseCallback onPause) {
+        Scheduler::Start();
+        // calibrates once; not something to do from the watcher's lock
+        const double ticksPerUs = Tsc::TicksPerUs();
+        std::lock_guard<std::mutex> lock(g_watcherMutex);
+        if (g_watcherStarted)
+            return;
+        g_pauseThreshold = std::chrono::milliseconds(thresholdMs);
+        g_ticksPerUs = ticksPerUs;
+        g_onPause = onPause;
+        g_watcherStarted = true;
+        if (g_state.load(std::memory_order_relaxed) == GameState::InGame)
+            ArmPauseWatcher();
+    }
+
+    void StopPauseWatcher() {
+        Scheduler::TaskId task;
+        {
+            std::lock_guard<std::mutex> lock(g_watcherMutex);
+            g_watcherStarted = false;
+            task = g_sampleTask;
+            g_sampleTask = 0;
+        }
+        // outside the lock: a sample in progress needs it to finish
+        Scheduler::Cancel(task);
+    }
+
+    WatcherStats GetWatcherStats() {
+        std::lock_guard<std::mutex> lock(g_watcherMutex);
+        return g_watcherStats;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+enum class GameState : uint8_t {
+    Idle,       // Game hasn't started yet
+    InGame,     // Gameplay is on
+    Paused      // Game is paused
+};
+
+// Game state machine and menu/pause detection.
+//
+// idHandsUpdate stops ticking as soon as an inner menu opens or the game is
+// paused, so the hook stamps each tick (Tsc.h) and a watcher task on the
+// scheduler (Scheduler.h) declares the game Paused once the last tick is the
+// threshold old. The watcher sleeps until the last tick it knows of would
+// reach the threshold, and isn't scheduled at all while there is nothing to
+// watch (Idle / Paused).
+namespace FSM {
+    using PauseCallback = void (*)();
+
+    struct WatcherStats {
+        uint64_t wakeups = 0;           // times the watcher task ran
+        uint64_t pauses = 0;            // pauses detected
+        double   lastLatencyMs = 0;     // last tick -> detected
+        double   maxLatencyMs = 0;
+        double   totalLatencyMs = 0;
+    };
+
+    GameState Get();
+    // stores the new state; entering InGame (re)arms the watcher and counts
+    // as a fresh heartbeat
+    void Set(GameState state);
+    const char *ToString(GameState state);
+
+    // Called every frame from idHandsUpdate_Hook while in gameplay; returns
+    // true if this tick resumed gameplay (i.e., Paused -> InGame)
+    bool Heartbeat();
+
+    void StartPauseWatcher(uint64_t thresholdMs, PauseCallback onPause);
+    void StopPauseWatcher();
+    WatcherStats GetWatcherStats();
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "HookStats.h"
+#include "Logger.h"
+#include "WeaponCache.h"
+
+#include <bit>
+
+int Histogram::Index(uint64_t value) {
+    if (value < kSubBuckets)
+        return (int)value;
+    const int msb = std::bit_width(value) - 1;
+    const int shift = msb - kSubBucketBits;
+    return kSubBuckets + shift * kSubBuckets +
+        (int)((value >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t Histogram::LowerBound(int index) {
+    if (index < kSubBuckets)
+        return (uint64_t)index;
+    const int shift = (index - kSubBuckets) / kSubBuckets;
+    const uint64_t sub = (uint64_t)((index - kSubBuckets) % kSubBuckets);
+    return (kSubBuckets + sub) << shift;
+}
+
+uint64_t Histogram::Count() const {
+    uint64_t count = 0;
+    for (auto& c : m_counts)
+        count += c.load(std::memory_order_relaxed);
+    return count;
+}
+
+uint64_t Histogram::Percentile(double p) const {
+    uint64_t counts[kBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (!total)
+        return 0;
+
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)total);
+    if (rank >= total)
+        rank = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += counts[i];
+        if (seen > rank)
+            return LowerBound(i);
+    }
+    return LowerBound(kBuckets - 1);
+}
+
+void Histogram::Reset() {
+    for (auto& c : m_counts)
+        c.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+static Histogram g_totalTicks[(int)HookId::Count];
+static Histogram g_selfTicks[(int)HookId::Count];
+static uint64_t g_dumpedCalls[(int)HookId::Count];
+static Histogram g_latencyTicks[(int)LatencyStage::Count];
+static uint64_t g_dumpedCommands[(int)LatencyStage::Count];
+// includes the original functions (the game's allocations don't count)
+static std::atomic<uint64_t> g_allocations[(int)HookId::Count];
+static std::atomic<uint64_t> g_allocatedBytes[(int)HookId::Count];
+
+static const char *StageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::HookToEnqueue: return "hook->enqueue";
+        case LatencyStage::EnqueueToSend: return "enqueue->send";
+        default:                          return "Unknown";
+    }
+}
+
+namespace HookStats {
+
+    void Record(HookId id, uint64_t totalTicks, uint64_t selfTicks) {
+        g_totalTicks[(int)id].Record(totalTicks);
+        g_selfTicks[(int)id].Record(selfTicks);
+    }
+
+    void RecordAllocations(HookId id, const AllocStats::Counters& delta) {
+        if (!delta.allocations)
+            return;
+        g_allocations[(int)id].fetch_add(delta.allocations,
+                std::memory_order_relaxed);
+        g_allocatedBytes[(int)id].fetch_add(delta.bytes,
+                std::memory_order_relaxed);
+    }
+
+    const Histogram& Total(HookId id) {
+        return g_totalTicks[(int)id];
+    }
+
+    const Histogram& Self(HookId id) {
+        return g_selfTicks[(int)id];
+    }
+
+    const char *Name(HookId id) {
+        switch (id) {
+            case HookId::OnWeaponSelected:           return "OnWeaponSelected";
+            case HookId::SelectWeaponByDeclExplicit: return "SelectWeaponByDeclExplicit";
+            case HookId::UpdateWeapon:               return "UpdateWeapon";
+            case HookId::UpdateAmmo:                 return "UpdateAmmo";
+            case HookId::SetFireMode:                return "SetFireMode";
+            case HookId::idHandsUpdate:              return "idHandsUpdate";
+            case HookId::Damage:                     return "Damage";
+            case HookId::LevelLoadCompleted:         return "LevelLoadCompleted";
+            default:                                 return "Unknown";
+        }
+    }
+
+    void RecordLatency(LatencyStage stage, uint64_t ticks) {
+        g_latencyTicks[(int)stage].Record(ticks);
+    }
+
+    const Histogram& Latency(LatencyStage stage) {
+        return g_latencyTicks[(int)stage];
+    }
+
+    void Dump() {
+        const double ticksPerUs = Tsc::TicksPerUs();
+        for (int i = 0; i < (int)HookId::Count; i++) {
+            const Histogram& total = g_totalTicks[i];
+            const Histogram& self = g_selfTicks[i];
+            const uint64_t calls = total.Count();
+            if (calls == g_dumpedCalls[i])
+                continue;
+            g_dumpedCalls[i] = calls;
+
+            _LOG("[HookStats] %s: %llu calls | total p50 %.2f p99 %.2f "
+                    "p99.9 %.2f us | self p50 %.2f p99 %.2f p99.9 %.2f us",
+                    Name((HookId)i),
+                    (unsigned long long)calls,
+                    total.Percentile(50) / ticksPerUs,
+                    total.Percentile(99) / ticksPerUs,
+                    total.Percentile(99.9) / ticksPerUs,
+                    self.Percentile(50) / ticksPerUs,
+                    self.Percentile(99) / ticksPerUs,
+                    self.Percentile(99.9) / ticksPerUs
+            );
+#ifdef DSMOD_ALLOC_STATS
+            _LOG("[HookStats] %s: %llu heap allocations (%llu bytes)",
+                    Name((HookId)i),
+                    (unsigned long long)g_allocations[i].exchange(0,
+                        std::memory_order_relaxed),
+                    (unsigned long long)g_allocatedBytes[i].exchange(0,
+                        std::memory_order_relaxed)
+            );
+#endif
+        }
+
+        for (int i = 0; i < (int)LatencyStage::Count; i++) {
+            const Histogram& latency = g_latencyTicks[i];
+            const uint64_t commands = latency.Count();
+            if (commands == g_dumpedCommands[i])
+                continue;
+            g_dumpedCommands[i] = commands;
+
+            _LOG("[HookStats] %s: %llu commands | p50 %.2f p99 %.2f "
+                    "p99.9 %.2f max %.2f us",
+                    StageName((LatencyStage)i),
+                    (unsigned long long)commands,
+                    latency.Percentile(50) / ticksPerUs,
+                    latency.Percentile(99) / ticksPerUs,
+                    latency.Percentile(99.9) / ticksPerUs,
+                    latency.Max() / ticksPerUs
+            );
+        }
+
+        static uint64_t dumpedLookups = 0;
+        const WeaponCache::Stats cache = WeaponCache::GetStats();
+        const uint64_t lookups = cache.hits + cache.misses;
+        if (lookups != dumpedLookups) {
+            dumpedLookups = lookups;
+            _LOG("[HookStats] weapon cache: %llu hits, %llu misses "
+                    "(%.1f%% hit rate), %llu invalidations",
+                    (unsigned long long)cache.hits,
+                    (unsigned long long)cache.misses,
+                    100.0 * cache.hits / lookups,
+                    (unsigned long long)cache.invalidations);
+        }
+    }
+}
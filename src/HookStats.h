@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include "AllocStats.h"
+#include "Timeline.h"
+#include "Tsc.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Per-hook latency histograms.
+//
+// Every detour installed by ApplyHooks times itself with the cycle counter,
+// both in total and excluding the call to the game's original function, into
+// lock-free log-linear (HDR-style) histograms. Recording is two counter reads
+// and two relaxed increments, so it stays on in release builds; the numbers
+// are dumped to the log periodically and at shutdown.
+enum class HookId : uint8_t {
+    OnWeaponSelected,
+    SelectWeaponByDeclExplicit,
+    UpdateWeapon,
+    UpdateAmmo,
+    SetFireMode,
+    idHandsUpdate,
+    Damage,
+    LevelLoadCompleted,
+
+    Count
+};
+
+// Where the time goes between a hook and the controller: from the hook that
+// triggered a command to the pipeline issuing it, and from there to the
+// transport having sent it. Commands that don't originate in a hook (pause
+// resets, resends) only have the second stage.
+enum class LatencyStage : uint8_t {
+    HookToEnqueue,
+    EnqueueToSend,
+
+    Count
+};
+
+class Histogram
+{
+public:
+    // 8 sub-buckets per power of two: values are off by at most 12.5%
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBuckets = kSubBuckets * (64 - kSubBucketBits + 1);
+
+    void Record(uint64_t value) {
+        m_counts[Index(value)].fetch_add(1, std::memory_order_relaxed);
+        // a new maximum is rare: the common case is one relaxed load
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value,
+                    std::memory_order_relaxed))
+            ;
+    }
+
+    uint64_t Count() const;
+    // lower bound of the bucket holding the p-th percentile (p in [0, 100])
+    uint64_t Percentile(double p) const;
+    // exact, unlike Percentile(100)
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+    void Reset();
+
+    static int Index(uint64_t value);
+    static uint64_t LowerBound(int index);
+
+private:
+    std::atomic<uint64_t> m_counts[kBuckets] = {};
+    std::atomic<uint64_t> m_max{0};
+};
+
+namespace HookStats {
+    void Record(HookId id, uint64_t totalTicks, uint64_t selfTicks);
+    // heap allocations made during a call (DSMOD_ALLOC_STATS builds)
+    void RecordAllocations(HookId id, const AllocStats::Counters& delta);
+    const Histogram& Total(HookId id);
+    const Histogram& Self(HookId id);
+    const char *Name(HookId id);
+
+    // when the outermost hook running on this thread started; 0 outside of
+    // hooks
+    inline thread_local uint64_t t_originTsc = 0;
+    inline uint64_t OriginTsc() { return t_originTsc; }
+    void RecordLatency(LatencyStage stage, uint64_t ticks);
+    const Histogram& Latency(LatencyStage stage);
+
+    // logs a summary of every hook, and of the command latencies, that saw
+    // calls since the last dump; the percentiles cover everything since the
+    // mod loaded. Then the weapon cache's hit rate, and with
+    // DSMOD_ALLOC_STATS, what each hook allocated since the last dump
+    void Dump();
+}
+
+// Times a hook from construction to destruction; wrap the call to the
+// original function in CallOriginal() to exclude it from the "self" time
+class HookTimer
+{
+public:
+    explicit HookTimer(HookId id) : m_id(id), m_start(Tsc::Now()) {
+#ifdef DSMOD_ALLOC_STATS
+        m_allocs = AllocStats::t_counters;
+#endif
+        // the game calls some hooked functions from others; a command's
+        // origin is the outermost one
+        m_outermost = !HookStats::t_originTsc;
+        if (m_outermost)
+            HookStats::t_originTsc = m_start;
+    }
+
+    ~HookTimer() {
+        if (m_outermost)
+            HookStats::t_originTsc = 0;
+        const uint64_t total = Tsc::Now() - m_start;
+        HookStats::Record(m_id, total, total - m_inOriginal);
+#ifdef DSMOD_ALLOC_STATS
+        const AllocStats::Counters& now = AllocStats::t_counters;
+        HookStats::RecordAllocations(m_id, { now.allocations -
+                m_allocs.allocations, now.bytes - m_allocs.bytes });
+#endif
+        if (Timeline::Enabled())
+            Timeline::Complete("hooks", HookStats::Name(m_id), m_start, total);
+    }
+
+    HookTimer(const HookTimer&) = delete;
+    HookTimer& operator=(const HookTimer&) = delete;
+
+    template <typename F>
+    decltype(auto) CallOriginal(F&& call) {
+        struct Guard {
+            uint64_t& ticks;
+            uint64_t start = Tsc::Now();
+            ~Guard() { ticks += Tsc::Now() - start; }
+        } guard{m_inOriginal};
+        return call();
+    }
+
+private:
+    HookId m_id;
+    uint64_t m_start;
+    uint64_t m_inOriginal = 0;
+    bool m_outermost;
+#ifdef DSMOD_ALLOC_STATS
+    AllocStats::Counters m_allocs;
+#endif
+};
+
+#ifndef DSMOD_NO_HOOK_STATS
+#define HOOK_TIMER(id) HookTimer _hookTimer(id)
+#define HOOK_ORIGINAL(call) \
+    _hookTimer.CallOriginal([&]() -> decltype(auto) { return call; })
+#else
+#define HOOK_TIMER(id) do {} while (0)
+#define HOOK_ORIGINAL(call) (call)
+#endif
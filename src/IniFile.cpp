@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "IniFile.h"
+
+#include <ctype.h>
+#include <stdio.h>
+
+#include <charconv>
+
+static std::string_view Trim(std::string_view s) {
+    const size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos)
+        return {};
+    const size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+static std::string Quoted(std::string_view s) {
+    std::string quoted;
+    quoted.reserve(s.size() + 2);
+    quoted += '\'';
+    quoted += s;
+    quoted += '\'';
+    return quoted;
+}
+
+bool IniFile::IEquals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+            return false;
+    }
+    return true;
+}
+
+bool IniFile::Load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        text.append(buf, n);
+    const bool ok = !ferror(f);
+    fclose(f);
+    if (ok)
+        Parse(std::move(text));
+    return ok;
+}
+
+void IniFile::Parse(std::string text) {
+    m_text = std::move(text);
+    m_sections.clear();
+    m_errors.clear();
+
+    std::string_view rest = m_text;
+    if (rest.substr(0, 3) == "\xEF\xBB\xBF")
+        rest.remove_prefix(3);
+
+    Section *current = nullptr;
+    int lineNo = 0;
+    while (!rest.empty()) {
+        const size_t eol = rest.find('\n');
+        const std::string_view line = Trim(rest.substr(0, eol));
+        rest.remove_prefix(eol == std::string_view::npos ?
+                rest.size() : eol + 1);
+        lineNo++;
+
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+            continue;
+
+        if (line[0] == '[') {
+            if (line.back() != ']') {
+                m_errors.push_back({ lineNo, "unterminated section header" });
+                current = nullptr;
+                continue;
+            }
+            m_sections.push_back(
+                    { Trim(line.substr(1, line.size() - 2)), lineNo, {} });
+            current = &m_sections.back();
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            m_errors.push_back({ lineNo, "expected 'key = value'" });
+            continue;
+        }
+        const std::string_view key = Trim(line.substr(0, eq));
+        std::string_view value = Trim(line.substr(eq + 1));
+        if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'') &&
+                value.back() == value[0])
+            value = value.substr(1, value.size() - 2);
+
+        if (!current) {
+            m_errors.push_back({ lineNo, Quoted(key) +
+                    " is outside of a section" });
+            continue;
+        }
+        bool duplicate = false;
+        for (const Entry& e : current->entries) {
+            if (IEquals(e.key, key)) {
+                m_errors.push_back({ lineNo, Quoted(key) +
+                        " already set on line " + std::to_string(e.line) });
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate)
+            current->entries.push_back({ key, value, lineNo });
+    }
+}
+
+const IniFile::Entry *IniFile::Find(std::string_view section,
+        std::string_view key) const {
+    // a handful of keys: scanning beats hashing them
+    for (const Section& s : m_sections) {
+        if (!IEquals(s.name, section))
+            continue;
+        for (const Entry& e : s.entries) {
+            if (IEquals(e.key, key))
+                return &e;
+        }
+    }
+    return nullptr;
+}
+
+void IniFile::Malformed(const Entry& entry, const char *expected) const {
+    m_errors.push_back({ entry.line, std::string(entry.key) + "=" +
+            std::string(entry.value) + " is not " + expected });
+}
+
+bool IniFile::Get(std::string_view section, std::string_view key,
+        std::string_view& value) const {
+    const Entry *e = Find(section, key);
+    if (!e)
+        return false;
+    value = e->value;
+    return true;
+}
+
+bool IniFile::Get(std::string_view section, std::string_view key,
+        bool& value) const {
+    const Entry *e = Find(section, key);
+    if (!e)
+        return false;
+    for (const char *t : { "true", "yes", "on", "1" }) {
+        if (IEquals(e->value, t)) {
+            value = true;
+            return true;
+        }
+    }
+    for (const char *f : { "false", "no", "off", "0" }) {
+        if (IEquals(e->value, f)) {
+            value = false;
+            return true;
+        }
+    }
+    Malformed(*e, "true or false");
+    return false;
+}
+
+bool IniFile::Get(std::string_view section, std::string_view key,
+        uint64_t& value) const {
+    const Entry *e = Find(section, key);
+    if (!e)
+        return false;
+    uint64_t n;
+    std::string_view digits = e->value;
+    int base = 10;
+    if (digits.size() > 2 && digits[0] == '0' &&
+            (digits[1] == 'x' || digits[1] == 'X')) {
+        digits.remove_prefix(2);
+        base = 16;
+    }
+    const char *end = digits.data() + digits.size();
+    auto [ptr, ec] = std::from_chars(digits.data(), end, n, base);
+    if (ec != std::errc() || ptr != end || digits.empty()) {
+        Malformed(*e, "a non-negative number");
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+bool IniFile::Get(std::string_view section, std::string_view key,
+        uint32_t& value) const {
+    uint64_t n = value;
+    if (!Get(section, key, n))
+        return false;
+    if (n > UINT32_MAX) {
+        Malformed(*Find(section, key), "a 32-bit number");
+        return false;
+    }
+    value = (uint32_t)n;
+    return true;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// INI file reader.
+//
+// Reads the file once and indexes its sections and keys as views into that
+// single buffer, instead of reopening and rescanning the file for every key
+// like GetPrivateProfileString does. Follows the same rules: section and
+// key names are case-insensitive, values are trimmed and may be quoted, and
+// the first of duplicate keys wins (later ones are reported). Only whole
+// lines are comments (';' or '#').
+class IniFile
+{
+public:
+    struct Error {
+        int line;               // 0: not tied to a line
+        std::string message;
+    };
+
+    struct Entry {
+        std::string_view key;
+        std::string_view value;
+        int line;
+    };
+
+    struct Section {
+        std::string_view name;
+        int line;
+        std::vector<Entry> entries;
+    };
+
+    IniFile() = default;
+    // the views point into m_text
+    IniFile(const IniFile&) = delete;
+    IniFile& operator=(const IniFile&) = delete;
+
+    // false if the file can't be read; syntax errors don't fail it, see
+    // Errors()
+    bool Load(const char *path);
+    void Parse(std::string text);
+
+    // in file order; a section that appears twice is listed twice
+    const std::vector<Section>& Sections() const { return m_sections; }
+    // syntax errors and malformed values asked for so far, in that order
+    const std::vector<Error>& Errors() const { return m_errors; }
+
+    const Entry *Find(std::string_view section, std::string_view key) const;
+
+    // Typed lookups. Return false and leave value (the default) as it is if
+    // the key is missing or malformed; a malformed value is also added to
+    // Errors().
+    bool Get(std::string_view section, std::string_view key,
+            std::string_view& value) const;
+    // true / false, yes / no, on / off, 1 / 0
+    bool Get(std::string_view section, std::string_view key,
+            bool& value) const;
+    // decimal, or hex with a 0x prefix
+    bool Get(std::string_view section, std::string_view key,
+            uint64_t& value) const;
+    bool Get(std::string_view section, std::string_view key,
+            uint32_t& value) const;
+
+    static bool IEquals(std::string_view a, std::string_view b);
+
+private:
+    void Malformed(const Entry& entry, const char *expected) const;
+
+    std::string m_text;
+    std::vector<Section> m_sections;
+    mutable std::vector<Error> m_errors;
+};
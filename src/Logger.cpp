@@ -1,10 +1,71 @@
 #include "Logger.h"
+#include "Recorder.h"
+#include "RingBuffer.h"
+#include "Scheduler.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#ifdef _WIN32
 #include <share.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+
+static constexpr size_t kMaxLine = 1024;
+
+struct LogRecord {
+    uint16_t len;
+    char text[kMaxLine];
+};
 
 FILE* logfile = nullptr;
 
+static RingBuffer<LogRecord, 512> g_logRing;
+static std::atomic<uint64_t> g_droppedLines{0};
+
+// the periodic flush on the scheduler thread
+static std::atomic<Scheduler::TaskId> g_flushTask{0};
+// set by the first Log() that asks for an early flush, cleared once the flush
+// task runs: the ones after it don't need to ask the scheduler again
+static std::atomic<bool> g_flushRequested{false};
+
+// how often queued lines hit the disk when nobody asks for it earlier
+static constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+
+// Only ever called by a single consumer: the flush task, or Close() once it's
+// been cancelled
+static void DrainLog() {
+    bool wrote = false;
+    while (g_logRing.TryPop([](const LogRecord& r) {
+        fwrite(r.text, 1, r.len, logfile);
+        fputc('\n', logfile);
+    })) {
+        wrote = true;
+    }
+
+    static uint64_t reportedDrops = 0;
+    uint64_t dropped = g_droppedLines.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops) {
+        fprintf(logfile, "[Logger] %llu line(s) dropped (ring full), "
+                "%llu in total\n",
+                (unsigned long long) (dropped - reportedDrops),
+                (unsigned long long) dropped);
+        reportedDrops = dropped;
+        wrote = true;
+    }
+    if (wrote)
+        fflush(logfile);
+}
+
+static void FlushTask() {
+    // before draining: lines queued from here on are ours or the next run's
+    g_flushRequested.store(false, std::memory_order_relaxed);
+    DrainLog();
+    Trace::Flush();
+    Recorder::Flush();
+}
+
 Logger::Logger()
 {
 }
@@ -15,24 +76,59 @@ Logger::~Logger()
 
 bool Logger::Open(const char * path)
 {
+#ifdef _WIN32
     logfile = _fsopen(path, "w", _SH_DENYWR);
+#else
+    // host-side tools
+    logfile = fopen(path, "w");
+#endif
+    if (logfile && !g_flushTask.load()) {
+        Scheduler::Start();
+        g_flushTask.store(Scheduler::Every(kFlushInterval, FlushTask));
+    }
     return logfile != NULL;
 }
 
-void Logger::Close()
+void Logger::Close(bool processTerminating)
 {
-    if (logfile) fclose(logfile);
+    if (!logfile) return;
+
+    const Scheduler::TaskId flushTask = g_flushTask.exchange(0);
+    // when the process is terminating the scheduler thread is already gone
+    if (flushTask && !processTerminating && !Scheduler::Cancel(flushTask))
+        return; // flush is stuck; don't race it for the ring
+
+    DrainLog();
+    fclose(logfile);
+    logfile = nullptr;
 }
 
 void Logger::Log(const char * format, ...)
 {
-    static char outputBuf[8192];
-    if (logfile) {
-        va_list args; va_start(args, format);
-        vsnprintf(outputBuf, sizeof(outputBuf), format, args);
-        va_end(args);
-        fprintf(logfile, "%s\n", outputBuf);
-        fflush(logfile);
+    if (!logfile) return;
+
+    thread_local char outputBuf[kMaxLine];
+    va_list args; va_start(args, format);
+    int len = vsnprintf(outputBuf, sizeof(outputBuf), format, args);
+    va_end(args);
+    if (len < 0) return;
+    if (len >= (int)sizeof(outputBuf)) len = sizeof(outputBuf) - 1;
+
+    bool queued = g_logRing.TryPush([&](LogRecord& r) {
+        r.len = (uint16_t)len;
+        memcpy(r.text, outputBuf, len);
+    });
+    if (!queued) {
+        g_droppedLines.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
+    // don't wait for the next flush interval if we're about to drop lines
+    if (g_logRing.Size() > g_logRing.capacity() / 2 &&
+            !g_flushRequested.exchange(true, std::memory_order_relaxed))
+        Scheduler::RunNow(g_flushTask.load(std::memory_order_relaxed));
 }
 
+uint64_t Logger::GetDroppedCount()
+{
+    return g_droppedLines.load(std::memory_order_relaxed);
+}
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "Config.h"
+#include "Trace.h"
 
+#include <cstdint>
+
+// Asynchronous logger: Log() formats on the calling thread into a per-thread
+// buffer and pushes the line into a lock-free ring; a periodic task on the
+// scheduler thread batches the writes to disk. When the ring is full lines are dropped (and
+// counted) instead of stalling the game.
 class Logger
 {
 public:
@@ -9,19 +16,78 @@ public:
     ~Logger();
 
     static bool Open(const char* path);
-    static void Close();
+    // flushes everything still queued; pass true from DLL_PROCESS_DETACH
+    // when the process is terminating (all other threads are already gone)
+    static void Close(bool processTerminating = false);
 
     static void Log(const char* format, ...);
+
+    static uint64_t GetDroppedCount();
 };
 
 extern Logger g_logger;
 extern Config g_config;
 
+// Log levels. Sites below DSMOD_LOG_LEVEL are compiled out entirely (the
+// build sets it; see DUALSENSE_MOD_LOG_LEVEL in CMakeLists.txt)
+#define LOG_LEVEL_TRACE 0   // per-frame / per-shot details
+#define LOG_LEVEL_DEBUG 1   // state changes, weapon switches
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+
+#ifndef DSMOD_LOG_LEVEL
+#define DSMOD_LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Log categories; trace and debug sites are filtered at runtime against
+// g_config.logMask, which holds the enabled debug categories in its low half
+// and the enabled trace categories in its high half
+enum LogCategory : uint32_t {
+    LOG_SIGSCAN   = 1 << 0,
+    LOG_HOOKS     = 1 << 1,
+    LOG_AMMO      = 1 << 2,
+    LOG_FSM       = 1 << 3,
+    LOG_TRANSPORT = 1 << 4,
+
+    LOG_ALL       = 0x1F
+};
+
+#define LOG_DEBUG_BIT(cat) ((uint32_t)(cat))
+#define LOG_TRACE_BIT(cat) ((uint32_t)(cat) << 16)
+
 #define _LOG(...) g_logger.Log(__VA_ARGS__)
 
-#define _LOGD(...) \
+// In trace mode filtered logs go to the binary trace (see Trace.h) instead of
+// being formatted on the calling thread
+#define _LOG_FILTERED(bit, ...) \
     do { \
-        if (g_config.isDebugMode) { \
-            _LOG(__VA_ARGS__); \
+        if (g_config.logMask & (bit)) { \
+            if (g_config.isTraceMode) { \
+                static const uint16_t _traceSite = Trace::RegisterSite( \
+                        __FILE__, __LINE__, Trace::FormatOf(__VA_ARGS__)); \
+                Trace::Write(_traceSite, __VA_ARGS__); \
+            } else { \
+                _LOG(__VA_ARGS__); \
+            } \
         } \
     } while (0)
+
+#if DSMOD_LOG_LEVEL <= LOG_LEVEL_TRACE
+#define _LOGT(cat, ...) _LOG_FILTERED(LOG_TRACE_BIT(cat), __VA_ARGS__)
+#else
+#define _LOGT(cat, ...) do {} while (0)
+#endif
+
+#if DSMOD_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define _LOGD(cat, ...) _LOG_FILTERED(LOG_DEBUG_BIT(cat), __VA_ARGS__)
+#else
+#define _LOGD(cat, ...) do {} while (0)
+#endif
+
+#if DSMOD_LOG_LEVEL <= LOG_LEVEL_INFO
+#define _LOGI(cat, ...) _LOG(__VA_ARGS__)
+#else
+#define _LOGI(cat, ...) do {} while (0)
+#endif
+
+#define _LOGW(cat, ...) _LOG(__VA_ARGS__)
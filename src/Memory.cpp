@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Memory.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <stdio.h>
+#endif
+
+namespace {
+    struct Region {
+        uintptr_t begin;
+        uintptr_t end;
+    };
+
+    std::mutex g_mapMutex;
+    std::vector<Region> g_regions;      // sorted, adjacent ones merged
+    bool g_mapped = false;
+}
+
+static void Add(std::vector<Region>& regions, uintptr_t begin,
+        uintptr_t end) {
+    if (!regions.empty() && regions.back().end == begin)
+        regions.back().end = end;
+    else
+        regions.push_back({ begin, end });
+}
+
+#ifdef _WIN32
+static bool IsReadableProtection(const MEMORY_BASIC_INFORMATION& info) {
+    if (info.State != MEM_COMMIT)
+        return false;
+    if (info.Protect & (PAGE_GUARD | PAGE_NOACCESS))
+        return false;
+    return (info.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY |
+            PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE |
+            PAGE_EXECUTE_WRITECOPY)) != 0;
+}
+#endif
+
+static std::vector<Region> ListRegions() {
+    std::vector<Region> regions;
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    uintptr_t addr = (uintptr_t)si.lpMinimumApplicationAddress;
+    const uintptr_t last = (uintptr_t)si.lpMaximumApplicationAddress;
+    MEMORY_BASIC_INFORMATION info;
+    while (addr < last &&
+            VirtualQuery((LPCVOID)addr, &info, sizeof(info)) == sizeof(info)) {
+        const uintptr_t begin = (uintptr_t)info.BaseAddress;
+        const uintptr_t end = begin + info.RegionSize;
+        if (IsReadableProtection(info))
+            Add(regions, begin, end);
+        if (end <= addr)
+            break;
+        addr = end;
+    }
+#elif defined(__linux__)
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (!maps)
+        return regions;
+    char line[512];
+    while (fgets(line, sizeof(line), maps)) {
+        unsigned long long begin, end;
+        char perms[5];
+        if (sscanf(line, "%llx-%llx %4s", &begin, &end, perms) == 3 &&
+                perms[0] == 'r')
+            Add(regions, (uintptr_t)begin, (uintptr_t)end);
+        // skip the rest of an overlong line (a long path)
+        while (!strchr(line, '\n') && fgets(line, sizeof(line), maps))
+            ;
+    }
+    fclose(maps);
+#endif
+    return regions;
+}
+
+// Readable bytes from addr on, up to max, according to regions
+static size_t Span(const std::vector<Region>& regions, uintptr_t addr,
+        size_t max) {
+    auto it = std::upper_bound(regions.begin(), regions.end(), addr,
+            [](uintptr_t a, const Region& r) { return a < r.end; });
+    if (it == regions.end() || addr < it->begin)
+        return 0;
+    // merged, so one region covers all there is
+    return (size_t)std::min<uintptr_t>(max, it->end - addr);
+}
+
+namespace Memory {
+
+    bool IsReadable(uintptr_t addr, size_t len) {
+        if (!len)
+            return true;
+        if (addr + len < addr)
+            return false;
+        std::lock_guard<std::mutex> lock(g_mapMutex);
+        if (g_mapped && Span(g_regions, addr, len) == len)
+            return true;
+        // not (yet) in the map: take it again before saying no
+        g_regions = ListRegions();
+        g_mapped = true;
+        return Span(g_regions, addr, len) == len;
+    }
+
+    bool Read(uintptr_t addr, void *data, size_t len) {
+        if (!IsReadable(addr, len))
+            return false;
+        memcpy(data, (const void *)addr, len);
+        return true;
+    }
+
+    size_t ReadableSpan(uintptr_t addr, size_t max) {
+#ifdef _WIN32
+        size_t span = 0;
+        MEMORY_BASIC_INFORMATION info;
+        while (span < max && VirtualQuery((LPCVOID)(addr + span), &info,
+                    sizeof(info)) == sizeof(info) &&
+                IsReadableProtection(info)) {
+            span = (uintptr_t)info.BaseAddress + info.RegionSize - addr;
+        }
+        return std::min(span, max);
+#else
+        return Span(ListRegions(), addr, max);
+#endif
+    }
+
+    void Invalidate() {
+        std::lock_guard<std::mutex> lock(g_mapMutex);
+        g_regions.clear();
+        g_mapped = false;
+    }
+}
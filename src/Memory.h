@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Reading the process's own memory without changing page protections.
+//
+// The readable regions (committed, not guard / no-access pages) are listed
+// once, through VirtualQuery on Windows and /proc/self/maps on Linux, and
+// kept sorted; a read from a readable region is then a plain memcpy. The
+// list is taken again when an address isn't in it, as regions come and go.
+// Changing protections (VirtualProtect) is left to writes.
+namespace Memory {
+    // [addr, addr + len) is in the cached map of readable regions. Meant for
+    // the game's image (code, data), which stays mapped for good.
+    bool IsReadable(uintptr_t addr, size_t len);
+    // copies len bytes at addr if they're readable; false otherwise
+    bool Read(uintptr_t addr, void *data, size_t len);
+
+    // How many bytes from addr on (up to max) are readable right now. Asks
+    // the OS rather than the cache, for heap objects that may be freed and
+    // their pages released at any time.
+    size_t ReadableSpan(uintptr_t addr, size_t max);
+
+    // drops the cached map (e.g. after a module was unloaded)
+    void Invalidate();
+}
@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Offsets.h"
+#include "GameHooks.h"
+#include "IniFile.h"
+#include "Logger.h"
+#include "Memory.h"
+#include "Scheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OFFSETS_HAS_SSE2 1
+#endif
+
+using Offsets::Id;
+using Offsets::State;
+
+namespace Offsets::detail {
+    std::atomic<uint32_t> g_offsets[kCount] = {
+        Hooks::kCurrWeaponHandleOffset,
+        Hooks::kAmmoCountOffset,
+    };
+    std::atomic<State> g_states[kCount];
+}
+
+using namespace Offsets::detail;
+
+struct OffsetInfo {
+    const char *name;       // also its key in the cache
+    uint32_t width;         // 8: qword, 4: dword
+    size_t scanSize;        // how much of the object a search looks at
+};
+
+static const OffsetInfo kInfo[Offsets::kCount] = {
+    { "player_weapon_handle",   8, 0x20000 },
+    { "ammo_count",             4, Offsets::kAmmoSnapshotSize },
+};
+
+// agreeing observations before an offset is trusted; disagreeing ones in a
+// row before it's searched for
+constexpr int kAgree = 3;
+constexpr int kDisagree = 3;
+// searches that found nothing before giving up
+constexpr int kMaxRounds = 8;
+constexpr size_t kMaxCandidates = 1024;
+
+// Only touched by the game thread (the hooks)
+struct Progress {
+    int agreed = 0;
+    int disagreed = 0;
+    int rounds = 0;
+    int confirmations = 0;      // observations the candidates went through
+    bool changed = false;       // ... with the value changing on the way
+    uint64_t lastValue = 0;
+    std::vector<uint32_t> candidates;
+    double searchUs = 0;        // time spent scanning, for the log
+};
+
+static Progress g_progress[Offsets::kCount];
+
+static std::mutex g_cacheMutex;
+static std::string g_cachePath;
+static uint64_t g_gameVersion = 0;
+// what the cache had for this version, so that we only write it on news
+static uint32_t g_cached[Offsets::kCount];
+static bool g_hasCached[Offsets::kCount];
+
+static std::string VersionSection(uint64_t version) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u",
+            (unsigned)(version >> 48) & 0xFFFF,
+            (unsigned)(version >> 32) & 0xFFFF,
+            (unsigned)(version >> 16) & 0xFFFF,
+            (unsigned)version & 0xFFFF);
+    return buf;
+}
+
+// Rewrites the cache with this version's verified offsets; the scheduler
+// runs it, the game thread only asks for it
+static void SaveCache() {
+    std::lock_guard<std::mutex> lock(g_cacheMutex);
+    if (g_cachePath.empty())
+        return;
+
+    const std::string section = VersionSection(g_gameVersion);
+    IniFile old;
+    old.Load(g_cachePath.c_str());
+
+    FILE *f = fopen(g_cachePath.c_str(), "w");
+    if (!f) {
+        _LOGW(LOG_SIGSCAN, "Failed to write %s", g_cachePath.c_str());
+        return;
+    }
+    fprintf(f, "; game object offsets found at runtime, per game version;\n"
+            "; delete this file to check them all again\n");
+    for (const IniFile::Section& s : old.Sections()) {
+        if (IniFile::IEquals(s.name, section))
+            continue;
+        fprintf(f, "\n[%.*s]\n", (int)s.name.size(), s.name.data());
+        for (const IniFile::Entry& e : s.entries) {
+            fprintf(f, "%.*s=%.*s\n", (int)e.key.size(), e.key.data(),
+                    (int)e.value.size(), e.value.data());
+        }
+    }
+    fprintf(f, "\n[%s]\n", section.c_str());
+    for (int id = 0; id < Offsets::kCount; id++) {
+        if (g_states[id].load() != State::Verified)
+            continue;
+        g_cached[id] = g_offsets[id].load();
+        g_hasCached[id] = true;
+        fprintf(f, "%s=0x%X\n", kInfo[id].name, g_cached[id]);
+    }
+    fclose(f);
+}
+
+static void Adopt(Id id, uint32_t offset) {
+    g_offsets[id].store(offset, std::memory_order_relaxed);
+    g_states[id].store(State::Verified, std::memory_order_relaxed);
+    g_progress[id].candidates = {};
+
+    bool news;
+    {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        news = !g_hasCached[id] || g_cached[id] != offset;
+    }
+    if (news)
+        Scheduler::After(std::chrono::milliseconds(0), SaveCache);
+}
+
+// How much of the object ObserveValue was last given can be read. The player
+// object it watches stays put across thousands of observations, and asking
+// the OS is a VirtualQuery loop (a /proc/self/maps parse on Linux), so it's
+// only asked once per object and again right before a search scans it.
+// Game thread only.
+struct ReadableObject {
+    const void *object = nullptr;
+    size_t span = 0;
+};
+
+static ReadableObject g_readable[Offsets::kCount];
+
+// The two kinds of observation, as "does the field at offset agree" and
+// "which fields agree"
+struct ValueCheck {
+    const uint8_t *object;
+    ReadableObject *readable;
+    size_t scanSize;
+    uint64_t value;
+    uint32_t width;
+
+    bool Holds(uint32_t offset) const {
+        if (offset + width > readable->span)
+            return false;
+        if (width == 8) {
+            uint64_t v;
+            memcpy(&v, object + offset, sizeof(v));
+            return v == value;
+        }
+        uint32_t v;
+        memcpy(&v, object + offset, sizeof(v));
+        return v == (uint32_t)value;
+    }
+
+    size_t Scan(uint32_t *out, size_t max) const {
+        // pages past the object may have come or gone since the span was
+        // last asked for
+        readable->span = Memory::ReadableSpan((uintptr_t)object, scanSize);
+        return width == 8 ?
+            Offsets::ScanQwords(object, readable->span, value, out, max) :
+            Offsets::ScanDwords(object, readable->span, (uint32_t)value,
+                    out, max);
+    }
+};
+
+struct DeltaCheck {
+    const uint8_t *object;
+    size_t span;                // readable, and before holds as much
+    const uint8_t *before;
+    int32_t delta;
+
+    bool Holds(uint32_t offset) const {
+        if (offset + sizeof(uint32_t) > span)
+            return false;
+        uint32_t now, then;
+        memcpy(&now, object + offset, sizeof(now));
+        memcpy(&then, before + offset, sizeof(then));
+        return (uint32_t)(now - then) == (uint32_t)delta;
+    }
+
+    size_t Scan(uint32_t *out, size_t max) const {
+        uint32_t diff[Offsets::kAmmoSnapshotSize / 4];
+        const size_t n = std::min(span, sizeof(diff)) / 4;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t now, then;
+            memcpy(&now, object + i * 4, sizeof(now));
+            memcpy(&then, before + i * 4, sizeof(then));
+            diff[i] = now - then;
+        }
+        return Offsets::ScanDwords((const uint8_t *)diff, n * 4,
+                (uint32_t)delta, out, max);
+    }
+};
+
+template <typename Check>
+static void Observe(Id id, const Check& check, uint64_t value,
+        bool valueChanges) {
+    Progress& p = g_progress[id];
+    const State state = g_states[id].load(std::memory_order_relaxed);
+
+    if (state == State::Unverified) {
+        if (check.Holds(Offsets::Get(id))) {
+            p.disagreed = 0;
+            // a field that merely holds the same value every time (a
+            // constant, a stale copy) proves nothing: it has to have
+            // followed the value through a change
+            if (!valueChanges || (p.agreed && value != p.lastValue))
+                p.changed = true;
+            p.lastValue = value;
+            if (++p.agreed >= kAgree && p.changed) {
+                _LOGD(LOG_SIGSCAN, "Offset %s 0x%X verified", kInfo[id].name,
+                        Offsets::Get(id));
+                Adopt(id, Offsets::Get(id));
+            }
+            return;
+        }
+        if (++p.disagreed < kDisagree)
+            return;
+        _LOGW(LOG_SIGSCAN, "Offset %s 0x%X doesn't match the game; "
+                "searching for it", kInfo[id].name, Offsets::Get(id));
+        g_states[id].store(State::Searching, std::memory_order_relaxed);
+        p.candidates.clear();
+        p.changed = false;
+    } else if (state != State::Searching) {
+        return;
+    }
+
+    if (p.candidates.empty()) {
+        if (++p.rounds > kMaxRounds) {
+            _LOGW(LOG_SIGSCAN, "Offset %s not found after %d searches "
+                    "(%.1f us); keeping 0x%X", kInfo[id].name, kMaxRounds,
+                    p.searchUs, Offsets::Get(id));
+            g_states[id].store(State::Failed, std::memory_order_relaxed);
+            p.candidates = {};
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        p.candidates.resize(kMaxCandidates);
+        const size_t found = check.Scan(p.candidates.data(), kMaxCandidates);
+        p.candidates.resize(std::min(found, kMaxCandidates));
+        p.searchUs += std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count();
+        p.confirmations = 0;
+        p.changed = false;
+        p.lastValue = value;
+        _LOGD(LOG_SIGSCAN, "Offset %s: search %d found %zu candidates",
+                kInfo[id].name, p.rounds, found);
+        return;
+    }
+
+    size_t kept = 0;
+    for (uint32_t offset : p.candidates) {
+        if (check.Holds(offset))
+            p.candidates[kept++] = offset;
+    }
+    p.candidates.resize(kept);
+    p.confirmations++;
+    if (!valueChanges || value != p.lastValue)
+        p.changed = true;
+    p.lastValue = value;
+
+    if (kept == 1 && p.changed && p.confirmations >= kAgree) {
+        _LOG("Offset %s found at 0x%X (was 0x%X; %d searches, %.1f us)",
+                kInfo[id].name, p.candidates[0], Offsets::Get(id),
+                p.rounds, p.searchUs);
+        Adopt(id, p.candidates[0]);
+    }
+}
+
+namespace Offsets {
+
+    State GetState(Id id) {
+        return g_states[id].load(std::memory_order_relaxed);
+    }
+
+    const char *Name(Id id) {
+        return kInfo[id].name;
+    }
+
+    void Load(const char *cachePath, uint64_t gameVersion) {
+        std::lock_guard<std::mutex> lock(g_cacheMutex);
+        g_cachePath = cachePath;
+        g_gameVersion = gameVersion;
+
+        IniFile cache;
+        if (!cache.Load(cachePath))
+            return;
+        const std::string section = VersionSection(gameVersion);
+        for (int id = 0; id < kCount; id++) {
+            uint64_t offset;
+            if (!cache.Get(section, kInfo[id].name, offset))
+                continue;
+            if (offset + kInfo[id].width > kInfo[id].scanSize) {
+                _LOGW(LOG_SIGSCAN, "%s: %s=0x%llX is out of range; ignored",
+                        cachePath, kInfo[id].name,
+                        (unsigned long long)offset);
+                continue;
+            }
+            // only verified offsets are written, per game version: this
+            // one already followed the game through a change
+            g_offsets[id].store((uint32_t)offset);
+            g_states[id].store(State::Verified, std::memory_order_relaxed);
+            g_cached[id] = (uint32_t)offset;
+            g_hasCached[id] = true;
+            _LOGD(LOG_SIGSCAN, "Offset %s 0x%X (verified for %s)",
+                    kInfo[id].name, (uint32_t)offset, section.c_str());
+        }
+    }
+
+    void ObserveValue(Id id, const void *object, uint64_t value) {
+        if (!object || !Checking(id))
+            return;
+        // fields further on than the object goes may be past the end of
+        // its pages
+        ReadableObject& readable = g_readable[id];
+        if (readable.object != object) {
+            readable.object = object;
+            readable.span = Memory::ReadableSpan((uintptr_t)object,
+                    kInfo[id].scanSize);
+        }
+        const ValueCheck check = {
+            (const uint8_t *)object, &readable, kInfo[id].scanSize, value,
+            kInfo[id].width
+        };
+        Observe(id, check, value, true);
+    }
+
+    void ObserveDelta(Id id, const void *object, const uint8_t *before,
+            size_t size, int32_t delta) {
+        if (!object || !delta || !Checking(id))
+            return;
+        const DeltaCheck check = {
+            (const uint8_t *)object, size, before, delta
+        };
+        // every delta is a change of the field
+        Observe(id, check, (uint32_t)delta, false);
+    }
+
+    size_t ScanQwords(const uint8_t *base, size_t len, uint64_t value,
+            uint32_t *out, size_t max) {
+        size_t found = 0;
+        size_t off = 0;
+        auto hit = [&](size_t offset) {
+            if (found < max)
+                out[found] = (uint32_t)offset;
+            found++;
+        };
+#ifdef OFFSETS_HAS_SSE2
+        // no 64-bit compare in SSE2: compare the halves, then require both
+        const __m128i needle = _mm_set1_epi64x((long long)value);
+        for (; off + 64 <= len; off += 64) {
+            __m128i eq[4];
+            for (int i = 0; i < 4; i++) {
+                const __m128i v = _mm_loadu_si128(
+                        (const __m128i *)(base + off + i * 16));
+                const __m128i e = _mm_cmpeq_epi32(v, needle);
+                eq[i] = _mm_and_si128(e,
+                        _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+            }
+            const __m128i any = _mm_or_si128(_mm_or_si128(eq[0], eq[1]),
+                    _mm_or_si128(eq[2], eq[3]));
+            if (!_mm_movemask_epi8(any))
+                continue;
+            for (int i = 0; i < 4; i++) {
+                const int mask = _mm_movemask_pd(_mm_castsi128_pd(eq[i]));
+                if (mask & 1)
+                    hit(off + i * 16);
+                if (mask & 2)
+                    hit(off + i * 16 + 8);
+            }
+        }
+#endif
+        for (; off + 8 <= len; off += 8) {
+            uint64_t v;
+            memcpy(&v, base + off, sizeof(v));
+            if (v == value)
+                hit(off);
+        }
+        return found;
+    }
+
+    size_t ScanDwords(const uint8_t *base, size_t len, uint32_t value,
+            uint32_t *out, size_t max) {
+        size_t found = 0;
+        size_t off = 0;
+        auto hit = [&](size_t offset) {
+            if (found < max)
+                out[found] = (uint32_t)offset;
+            found++;
+        };
+#ifdef OFFSETS_HAS_SSE2
+        const __m128i needle = _mm_set1_epi32((int)value);
+        for (; off + 64 <= len; off += 64) {
+            __m128i eq[4];
+            for (int i = 0; i < 4; i++) {
+                eq[i] = _mm_cmpeq_epi32(needle, _mm_loadu_si128(
+                        (const __m128i *)(base + off + i * 16)));
+            }
+            const __m128i any = _mm_or_si128(_mm_or_si128(eq[0], eq[1]),
+                    _mm_or_si128(eq[2], eq[3]));
+            if (!_mm_movemask_epi8(any))
+                continue;
+            for (int i = 0; i < 4; i++) {
+                const int mask = _mm_movemask_ps(_mm_castsi128_ps(eq[i]));
+                for (int j = 0; j < 4; j++) {
+                    if (mask & (1 << j))
+                        hit(off + i * 16 + j * 4);
+                }
+            }
+        }
+#endif
+        for (; off + 4 <= len; off += 4) {
+            uint32_t v;
+            memcpy(&v, base + off, sizeof(v));
+            if (v == value)
+                hit(off);
+        }
+        return found;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Game object field offsets, checked (and found again) at runtime.
+//
+// The functions the mod hooks are found by signature, but the fields it
+// reads inside game objects were found by hand and move with game updates.
+// An offset cached for this game version was verified when it was written
+// and is used as is. Otherwise it starts from the built-in value and is
+// checked against what the hooks see: the handle the player reports for its
+// current weapon, the ammo delta the game has just applied. After a few
+// agreeing observations, with the value changing at least once on the way,
+// it's trusted and not checked any more. If it keeps disagreeing, the
+// object is scanned (64 bytes at a time) for every field holding the
+// observed value, and the candidates are narrowed down over the next
+// observations until one remains that has followed the value through a
+// change; that one is used from then on and written to the cache for this
+// game version.
+namespace Offsets {
+    enum Id : uint8_t {
+        PlayerWeaponHandle,     // idPlayer: current weapon handle (qword)
+        AmmoCount,              // idInventoryItem_Ammo: count (dword)
+        kCount
+    };
+
+    enum class State : uint8_t {
+        Unverified,     // in use, being checked
+        Searching,      // in use, but disagreed: narrowing down candidates
+        Verified,       // agreed with the game; no more checks
+        Failed          // couldn't be found; the last one stays in use
+    };
+
+    // how much of an ammo item UpdateAmmo_Hook copies while its count
+    // offset isn't verified
+    constexpr size_t kAmmoSnapshotSize = 0x80;
+
+    namespace detail {
+        extern std::atomic<uint32_t> g_offsets[kCount];
+        extern std::atomic<State> g_states[kCount];
+    }
+
+    inline uint32_t Get(Id id) {
+        return detail::g_offsets[id].load(std::memory_order_relaxed);
+    }
+
+    // true while hooks should keep reporting observations for id
+    inline bool Checking(Id id) {
+        const State state = detail::g_states[id].load(std::memory_order_relaxed);
+        return state == State::Unverified || state == State::Searching;
+    }
+
+    State GetState(Id id);
+    const char *Name(Id id);
+
+    // Uses (as Verified) the offsets cached for gameVersion in cachePath, if
+    // any
+    void Load(const char *cachePath, uint64_t gameVersion);
+
+    // The game thread's observations. ObserveValue: object has the field
+    // holding value; ObserveDelta: the field went up by delta since before
+    // (a copy of the object's first size bytes, up to kAmmoSnapshotSize)
+    void ObserveValue(Id id, const void *object, uint64_t value);
+    void ObserveDelta(Id id, const void *object, const uint8_t *before,
+            size_t size, int32_t delta);
+
+    // Offsets (multiples of 8 / 4) in base[0, len) holding value; returns
+    // how many there are, storing up to max of them
+    size_t ScanQwords(const uint8_t *base, size_t len, uint64_t value,
+            uint32_t *out, size_t max);
+    size_t ScanDwords(const uint8_t *base, size_t len, uint32_t value,
+            uint32_t *out, size_t max);
+}
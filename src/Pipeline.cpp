@@ -0,0 +1,590 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Pipeline.h"
+#include "GameState.h"
+#include "HookStats.h"
+#include "Logger.h"
+#include "Recorder.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+enum class Command : uint8_t { None, Weapon, Reset, NoAmmo };
+
+// The game thread and the pause watcher both talk to the controller, so the
+// commands are serialized here, along with the last one so that it can be
+// sent again once the transport (re)connects
+static std::mutex g_sinkMutex;
+static TriggerSink *g_sink = nullptr;
+static Command g_lastCommand = Command::None;
+static const char *g_lastWeaponId = nullptr;
+static Pipeline::Stats g_stats;
+
+static const void *g_currPlayer = nullptr;
+static const void *g_currWeapon = nullptr;
+// read from the weapon when it was selected; may be null
+static const char *g_currWeaponName = nullptr;
+
+static unsigned int g_previousMode = 0;
+
+// Player's death status; cached from the damage hook and cleared on level
+// load or when the player object gets reset so that the per-frame hands
+// tick doesn't need to call idPlayer::IsDead
+static std::atomic<bool> g_PlayerDead{false};
+
+static void print_state()
+{
+    _LOGD(LOG_FSM, "*current state: %s", FSM::ToString(FSM::Get()));
+}
+
+// Unknown: a weapon missing from g_Weapons; they all share one ammo item
+enum class AmmoType : uint8_t {
+    Unknown, Infinite, Bullets, Shells, Rockets, Plasma, Cells, Fuel, Count
+};
+
+static const char *ToString(AmmoType type) {
+    static const char *const names[] = {
+        "unknown", "infinite", "bullets", "shells", "rockets", "plasma",
+        "cells", "fuel"
+    };
+    return names[(size_t)type];
+}
+
+struct WeaponInfo {
+    const char *name;       // weapon decl; what the sink gets
+    const char *modId;      // with the weapon mod active; null: no settings
+    AmmoType ammo;
+};
+
+// Everything the pipeline needs per weapon, looked up once when the weapon
+// is selected so that the ammo and fire mode updates don't have to
+static const WeaponInfo g_Weapons[] = {
+  {"weapon/zion/player/sp/fists",                    nullptr, AmmoType::Infinite},
+  {"weapon/zion/player/sp/fists_berserk",            nullptr, AmmoType::Infinite},
+  {"weapon/zion/player/sp/pistol",                   nullptr, AmmoType::Infinite},
+  {"weapon/zion/player/sp/heavy_rifle_heavy_ar",
+      "weapon/zion/player/sp/heavy_rifle_heavy_ar_mod",     AmmoType::Bullets},
+  {"weapon/zion/player/sp/heavy_rifle_heavy_ar_mod", nullptr, AmmoType::Bullets},
+  {"weapon/zion/player/sp/chaingun",
+      "weapon/zion/player/sp/chaingun_mod",                 AmmoType::Bullets},
+  {"weapon/zion/player/sp/chaingun_mod",             nullptr, AmmoType::Bullets},
+  {"weapon/zion/player/sp/shotgun",
+      "weapon/zion/player/sp/shotgun_mod",                  AmmoType::Shells},
+  {"weapon/zion/player/sp/shotgun_mod",              nullptr, AmmoType::Shells},
+  {"weapon/zion/player/sp/double_barrel",            nullptr, AmmoType::Shells},
+  {"weapon/zion/player/sp/rocket_launcher",
+      "weapon/zion/player/sp/rocket_launcher_mod",          AmmoType::Rockets},
+  {"weapon/zion/player/sp/rocket_launcher_mod",      nullptr, AmmoType::Rockets},
+  {"weapon/zion/player/sp/plasma_rifle",             nullptr, AmmoType::Plasma},
+  {"weapon/zion/player/sp/gauss_rifle",
+      "weapon/zion/player/sp/gauss_rifle_mod",              AmmoType::Plasma},
+  {"weapon/zion/player/sp/gauss_rifle_mod",          nullptr, AmmoType::Plasma},
+  {"weapon/zion/player/sp/bfg",                      nullptr, AmmoType::Cells},
+  {"weapon/zion/player/sp/chainsaw",                 nullptr, AmmoType::Fuel},
+};
+
+static const WeaponInfo g_UnknownWeapon = { nullptr, nullptr, AmmoType::Unknown };
+
+static const WeaponInfo& findWeapon(const char *name) {
+    if (name) {
+        for (const WeaponInfo& w : g_Weapons) {
+            if (!strcmp(w.name, name))
+                return w;
+        }
+    }
+    return g_UnknownWeapon;
+}
+
+// the ammo item each ammo type was first seen updating with
+static const void *g_AmmoPtrs[(size_t)AmmoType::Count] = {};
+
+static void resetAmmoPtrs() {
+    std::fill(std::begin(g_AmmoPtrs), std::end(g_AmmoPtrs), nullptr);
+}
+
+// Whether each ammo item seen since the last reset has ammo left. Open
+// addressing over a fixed table in the DLL's static data (off the heap the
+// engine's threads contend on): a player carries a handful of ammo items,
+// so this only fills up if they're never reset, and then it starts over
+// (the items report again on their next update).
+class AmmoStates
+{
+public:
+    // the item's slot, added (without ammo) if it's new
+    bool& operator[](const void *ammo) {
+        Slot *slot = &m_slots[find(ammo)];
+        if (!slot->ammo) {
+            if (m_used == kSlots * 3 / 4) {
+                _LOGD(LOG_AMMO, "* %zu ammo items seen, starting over", m_used);
+                clear();
+                slot = &m_slots[find(ammo)];
+            }
+            slot->ammo = ammo;
+            m_used++;
+        }
+        return slot->hasAmmo;
+    }
+
+    bool get(const void *ammo) const {
+        return m_slots[find(ammo)].hasAmmo;
+    }
+
+    void clear() {
+        std::fill(std::begin(m_slots), std::end(m_slots), Slot());
+        m_used = 0;
+    }
+
+private:
+    struct Slot {
+        const void *ammo = nullptr;
+        bool hasAmmo = false;
+    };
+    static constexpr size_t kSlots = 64;
+
+    // the item's slot, or the empty one where it would go
+    size_t find(const void *ammo) const {
+        // Fibonacci hashing: the top 6 bits pick one of the kSlots
+        static_assert(kSlots == 64);
+        size_t i = ((uintptr_t)ammo >> 4) * 0x9E3779B97F4A7C15ull >> 58;
+        while (m_slots[i].ammo && m_slots[i].ammo != ammo)
+            i = (i + 1) & (kSlots - 1);
+        return i;
+    }
+
+    Slot m_slots[kSlots];
+    size_t m_used = 0;
+};
+
+static AmmoStates g_HasAmmo;
+
+static bool HasAmmo(const WeaponInfo& weapon) {
+    if (weapon.ammo == AmmoType::Infinite)
+        return true;
+    const void *ammo = g_AmmoPtrs[(size_t)weapon.ammo];
+    if (!ammo) {
+        _LOGT(LOG_AMMO, "HasAmmo - Ptr for %s found null!",
+                ToString(weapon.ammo));
+        return false;
+    }
+    return g_HasAmmo.get(ammo);
+}
+
+// set along with g_currWeaponName
+static const WeaponInfo *g_currWeaponInfo = &g_UnknownWeapon;
+
+// The output stage, between the pipeline's decisions and the sink. A
+// burst of commands (e.g. fire mode toggles) is worth no more to the
+// controller than its last one, so writes are capped by a token bucket:
+// while it's empty, the newest command waits for the next token and
+// replaces any older one still waiting. Unlimited unless SetOutputRate was
+// called. All of it is guarded by g_sinkMutex.
+struct Output {
+    Command command = Command::None;
+    const char *weaponId = nullptr;
+    // Tsc when it entered the output stage; merged commands keep the
+    // oldest, so EnqueueToSend includes the time spent waiting for a token
+    uint64_t enqueued = 0;
+
+    bool operator==(const Output& o) const {
+        return command == o.command && (command != Command::Weapon ||
+                weaponId == o.weaponId || !strcmp(weaponId, o.weaponId));
+    }
+};
+
+static Output g_written;        // last one handed to the sink
+static Output g_pending;        // waiting for a token
+static bool g_flushScheduled = false;
+
+using Clock = std::chrono::steady_clock;
+static uint32_t g_ratePerSec = 0;   // 0: unlimited
+static uint32_t g_burst = 1;
+static double g_tokens = 0;
+static Clock::time_point g_refilled;
+
+// called with g_sinkMutex held
+static void writeCommand(const Output& out) {
+    if (!g_sink)
+        return;
+    switch (out.command) {
+        case Command::Weapon: g_sink->SendWeapon(out.weaponId); break;
+        case Command::Reset:  g_sink->Reset(); break;
+        case Command::NoAmmo: g_sink->NoAmmo(); break;
+        default: return;
+    }
+    g_written = out;
+    g_stats.written++;
+    HookStats::RecordLatency(LatencyStage::EnqueueToSend,
+            Tsc::Now() - out.enqueued);
+}
+
+// called with g_sinkMutex held; true if a token was taken
+static bool takeToken() {
+    const Clock::time_point now = Clock::now();
+    const double elapsed =
+        std::chrono::duration<double>(now - g_refilled).count();
+    g_tokens = std::min<double>(g_burst, g_tokens + elapsed * g_ratePerSec);
+    g_refilled = now;
+    if (g_tokens < 1)
+        return false;
+    g_tokens -= 1;
+    return true;
+}
+
+static void flushPending();
+
+// called with g_sinkMutex held
+static void scheduleFlush() {
+    if (g_flushScheduled)
+        return;
+    g_flushScheduled = true;
+    const double wait = (1 - g_tokens) / g_ratePerSec;
+    Scheduler::After(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(wait)), flushPending);
+}
+
+// scheduler task: the pending command once a token is in
+static void flushPending() {
+    std::lock_guard<std::mutex> lock(g_sinkMutex);
+    g_flushScheduled = false;
+    if (g_pending.command == Command::None)
+        return;
+    if (!takeToken()) {
+        scheduleFlush();
+        return;
+    }
+    const Output out = g_pending;
+    g_pending = Output();
+    // what the commands merged into it came back to
+    if (out == g_written) {
+        g_stats.dropped++;
+        return;
+    }
+    writeCommand(out);
+}
+
+// called with g_sinkMutex held
+static void sendCommand(Command command, const char *weaponId) {
+    Output out = { command, weaponId, Tsc::Now() };
+    if (const uint64_t origin = HookStats::OriginTsc())
+        HookStats::RecordLatency(LatencyStage::HookToEnqueue,
+                out.enqueued - origin);
+    if (!g_ratePerSec) {
+        writeCommand(out);
+        return;
+    }
+    if (g_pending.command == Command::None && takeToken()) {
+        writeCommand(out);
+        return;
+    }
+    if (g_pending.command != Command::None) {
+        g_stats.merged++;
+        out.enqueued = g_pending.enqueued;
+    }
+    g_pending = out;
+    scheduleFlush();
+}
+
+// called with g_sinkMutex held
+static void emitCommandLocked(Command command, const char *weaponId) {
+    g_stats.commands++;
+    if (command == g_lastCommand && (command != Command::Weapon ||
+                weaponId == g_lastWeaponId || !strcmp(weaponId, g_lastWeaponId)))
+        g_stats.repeated++;
+    g_lastCommand = command;
+    if (command == Command::Weapon)
+        g_lastWeaponId = weaponId;
+    sendCommand(command, weaponId);
+}
+
+static void emitCommand(Command command, const char *weaponId = nullptr) {
+    std::lock_guard<std::mutex> lock(g_sinkMutex);
+    // Weapon settings only go out in gameplay; entering it (level start,
+    // resume) sends the current weapon's. Checked under the lock so that a
+    // pause declared by the watcher can't slip in between.
+    if (command != Command::Reset && FSM::Get() != GameState::InGame) {
+        g_stats.deferred++;
+        return;
+    }
+    emitCommandLocked(command, weaponId);
+}
+
+// name: the weapon's, which outlives the command (the game keeps its decls
+// for good)
+static void SendTriggers(const WeaponInfo& weapon, const char *name,
+        bool mod = false) {
+    const char *weaponId = name;
+    if (mod) {
+        if (!weapon.modId) {
+           _LOGD(LOG_TRANSPORT, "* No mod settings found for %s", name);
+           return;
+        }
+        weaponId = weapon.modId;
+    }
+    emitCommand(Command::Weapon, weaponId);
+    _LOGD(LOG_TRANSPORT, "Adaptive Trigger settings sent successfully!");
+}
+
+static void resetAdaptiveTriggers() {
+    emitCommand(Command::Reset);
+    _LOGD(LOG_TRANSPORT, "Adaptive Triggers reset successfully!");
+}
+
+static void noAmmoAdaptiveTriggers() {
+    emitCommand(Command::NoAmmo);
+    _LOGD(LOG_TRANSPORT, "No Ammo Adaptive Triggers set successfully!");
+}
+
+static void sendAdaptiveTriggersForCurrentWeapon(bool mod = false) {
+    const char *currWeaponName = g_currWeapon ? g_currWeaponName : nullptr;
+    _LOGD(LOG_HOOKS, "* curr weapon: %s!", currWeaponName);
+    if (currWeaponName && HasAmmo(*g_currWeaponInfo)){
+        _LOGD(LOG_TRANSPORT, "* Sending adaptive trigger setting!");
+        SendTriggers(*g_currWeaponInfo, currWeaponName, mod);
+        return;
+    }
+    _LOGD(LOG_TRANSPORT, "* No valid weapon name or no ammo - resetting triggers!");
+    noAmmoAdaptiveTriggers();
+}
+
+static void setCurrentWeapon(const void *weapon, const char *name) {
+    g_currWeapon = weapon;
+    if (name != g_currWeaponName || !name)
+        g_currWeaponInfo = &findWeapon(name);
+    g_currWeaponName = name;
+}
+
+namespace Pipeline {
+
+    void SetSink(TriggerSink *sink) {
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        g_sink = sink;
+    }
+
+    void Resend() {
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        if (g_lastCommand == Command::None)
+            return;
+        g_stats.resends++;
+        // the newest decision, now: it supersedes any pending one
+        g_pending = Output();
+        writeCommand({ g_lastCommand, g_lastWeaponId, Tsc::Now() });
+    }
+
+    void SetOutputRate(uint32_t perSecond, uint32_t burst) {
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        g_ratePerSec = perSecond;
+        g_burst = std::max<uint32_t>(burst, 1);
+        g_tokens = g_burst;
+        g_refilled = Clock::now();
+        if (!perSecond && g_pending.command != Command::None) {
+            writeCommand(g_pending);
+            g_pending = Output();
+        }
+    }
+
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lock(g_sinkMutex);
+        return g_stats;
+    }
+
+    void Reset() {
+        g_currPlayer = nullptr;
+        setCurrentWeapon(nullptr, nullptr);
+        g_previousMode = 0;
+        g_PlayerDead.store(false, std::memory_order_relaxed);
+        g_HasAmmo.clear();
+        resetAmmoPtrs();
+    }
+
+    const void *CurrentPlayer() {
+        return g_currPlayer;
+    }
+
+    bool IsCurrentPlayer(const void *player) {
+        return player && player == g_currPlayer;
+    }
+
+    void OnWeaponSelected(const void *weapon, const char *name) {
+        Recorder::Record(RecordFormat::WeaponSelected, weapon, 0, 0, name);
+        setCurrentWeapon(weapon, name);
+        bool hasAmmo = name && HasAmmo(*g_currWeaponInfo);
+        _LOGD (
+                LOG_HOOKS,
+                "idPlayer::OnWeaponSelected - newWeapon = %s, hasAmmo: %s\n",
+                name, hasAmmo ? "true" : "false"
+        );
+        sendAdaptiveTriggersForCurrentWeapon();
+    }
+
+    void OnSelectWeaponByDecl(const void *weapon, const char *name) {
+        Recorder::Record(RecordFormat::SelectWeaponByDecl, weapon, 0, 0, name);
+        if (!weapon)
+            return;
+        if (name && name[0]) {
+            _LOGD(LOG_HOOKS, "* (init) curr weapon: %s", name);
+        }
+        setCurrentWeapon(weapon, name);
+    }
+
+    void OnSelectWeaponByDeclDone() {
+        Recorder::Record(RecordFormat::SelectWeaponByDeclDone);
+        // reset player here (paused used for loading the latest checkpoint
+        // from the main menu)
+        if (g_currPlayer && (FSM::Get() == GameState::Idle ||
+                    FSM::Get() == GameState::Paused)) {
+            FSM::Set(GameState::Idle);
+            g_currPlayer = nullptr;
+            g_PlayerDead.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void OnUpdateWeapon(const void *player) {
+        if (g_currPlayer)
+            return;
+        Recorder::Record(RecordFormat::UpdateWeapon, player);
+        _LOGD(LOG_HOOKS, "* set idPlayer!");
+        g_currPlayer = player;
+        g_PlayerDead.store(false, std::memory_order_relaxed);
+    }
+
+    void OnAmmoUpdate(const void *ammo, int count) {
+        Recorder::Record(RecordFormat::AmmoUpdate, ammo, (uint32_t)count);
+        bool& hasAmmo = g_HasAmmo[ammo];
+        const bool hadAmmo = hasAmmo;
+        hasAmmo = count > 0;
+
+        if (!g_currWeapon || !g_currWeaponName)
+            return;
+
+        const AmmoType ammoType = g_currWeaponInfo->ammo;
+        if (ammoType == AmmoType::Infinite)
+            return;
+        const void *&currAmmo = g_AmmoPtrs[(size_t)ammoType];
+        const bool bound = currAmmo != nullptr;
+        if (!bound) {
+            currAmmo = ammo;
+            _LOGD(LOG_AMMO, "g_AmmoPtrs[%s] = %p, |(%p)|",
+                    ToString(ammoType), ammo, currAmmo
+            );
+        }
+        if (currAmmo != ammo)
+            return;
+
+        // The current weapon just ran dry or got ammo back (an unbound one
+        // counted as dry): switch the triggers now instead of on the next
+        // weapon or fire mode change, so that the empty click comes with
+        // the very next pull
+        if (bound ? hasAmmo != hadAmmo : hasAmmo) {
+            _LOGD(LOG_AMMO, "* %s %s", ToString(ammoType),
+                    hasAmmo ? "refilled" : "ran out");
+            sendAdaptiveTriggersForCurrentWeapon(
+                    g_previousMode != 0 && g_currWeaponInfo->modId);
+        }
+    }
+
+    void OnFireModeSet(bool ok, uint32_t mode) {
+        Recorder::Record(RecordFormat::FireModeSet, nullptr, mode, ok);
+        if (!g_currPlayer || !g_currWeapon)
+            return;
+        if (ok && mode != g_previousMode) {
+            print_state();
+            _LOGD(LOG_HOOKS, "* SetFireMode hook! curr weapon: %p  "
+                    "| g_previousMode: %d, current: %d",
+                    g_currWeapon,
+                    g_previousMode, mode
+            );
+            sendAdaptiveTriggersForCurrentWeapon((bool)mode);
+        }
+        g_previousMode = mode;
+    }
+
+    void OnHandsTick() {
+        Recorder::Record(RecordFormat::HandsTick);
+        if (FSM::Get() == GameState::Idle)
+            return;
+        // Always tick the heartbeat when we are truly in gameplay.
+        // Pausing is detected by FSM's watcher once these ticks stop.
+        if (g_currPlayer && !g_PlayerDead.load(std::memory_order_relaxed)) {
+            if (FSM::Heartbeat()) {
+                _LOGD(LOG_FSM, "[FSM] -> InGame (hands ticking)");
+                // replay last trigger settings here
+                sendAdaptiveTriggersForCurrentWeapon();
+            }
+        }
+    }
+
+    void OnPlayerDamaged(bool isDead) {
+        Recorder::Record(RecordFormat::PlayerDamaged, nullptr, 0, isDead);
+        if (!isDead)
+            return;
+        g_PlayerDead.store(true, std::memory_order_relaxed);
+        FSM::Set(GameState::Idle);
+        resetAdaptiveTriggers();
+        setCurrentWeapon(nullptr, nullptr);
+        g_HasAmmo.clear(); // reset ammo info
+        resetAmmoPtrs();
+        _LOGD(LOG_FSM, "* Damage hook, Player is DEAD! Switching to Idle state...");
+    }
+
+    bool OnLevelLoaded() {
+        Recorder::Record(RecordFormat::LevelLoaded);
+        // either a new level or a checkpoint reload; the player lives again
+        g_PlayerDead.store(false, std::memory_order_relaxed);
+        if (g_currPlayer && FSM::Get() == GameState::Paused) {
+            FSM::Set(GameState::Idle);
+            resetAdaptiveTriggers();
+            setCurrentWeapon(nullptr, nullptr);
+            //g_HasAmmo.clear(); // reset ammo info
+            //resetAmmoPtrs();
+            _LOGD(LOG_FSM, "* Exiting to main menu! Switching to Idle state...");
+            return false;
+        }
+        if (g_currPlayer && FSM::Get() == GameState::Idle) {
+            FSM::Set(GameState::InGame);
+            return true;
+        }
+        return false;
+    }
+
+    void OnLevelStartWeapon(const void *weapon, const char *name) {
+        Recorder::Record(RecordFormat::LevelStartWeapon, weapon, 0, 0, name);
+        if (!weapon) {
+            _LOGD(LOG_HOOKS, "* curr weapon: (not found!)");
+            return;
+        }
+        if (name && name[0]) {
+            setCurrentWeapon(weapon, name);
+            bool hasAmmo = HasAmmo(*g_currWeaponInfo);
+            _LOGD (
+                    LOG_HOOKS,
+                    "* curr weapon = %s, hasAmmo: %s\n",
+                    name, hasAmmo ? "true" : "false"
+            );
+        }
+        // enable triggers
+        sendAdaptiveTriggersForCurrentWeapon();
+    }
+
+    void OnPaused() {
+        Recorder::Record(RecordFormat::Paused);
+        {
+            // the game thread may have resumed (and sent the weapon's
+            // settings) since the watcher declared the pause; resetting now
+            // would leave the triggers off in gameplay
+            std::lock_guard<std::mutex> lock(g_sinkMutex);
+            if (FSM::Get() != GameState::Paused) {
+                g_stats.stalePauses++;
+                return;
+            }
+            emitCommandLocked(Command::Reset, nullptr);
+        }
+        _LOGD(LOG_TRANSPORT, "Adaptive Triggers reset successfully!");
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Where the pipeline's decisions go: the DualSensitive client in the game,
+// a mock in tools/replay
+class TriggerSink
+{
+public:
+    virtual ~TriggerSink() = default;
+
+    // the weapon's adaptive trigger settings; weaponId carries the "_mod"
+    // suffix when the weapon mod is active, and stays valid for good
+    virtual void SendWeapon(const char *weaponId) = 0;
+    // both triggers back to normal (menus, death)
+    virtual void Reset() = 0;
+    // out of ammo: normal L2, GameCube-style R2
+    virtual void NoAmmo() = 0;
+};
+
+// Game events -> adaptive trigger settings.
+//
+// The hooks decode what they need from the game's objects (weapon names,
+// ammo counts, fire modes, ...) and report it through the entry points
+// below; everything that decides what the triggers should do lives here and
+// talks to the controller only through a TriggerSink. Nothing in here reads
+// game memory (objects are opaque ids), so it builds on any platform and
+// tools/replay can drive it from a recorded session.
+namespace Pipeline {
+    struct Stats {
+        uint64_t commands = 0;      // commands issued
+        uint64_t repeated = 0;      // ... identical to the one before
+        uint64_t deferred = 0;      // weapon settings held back: not in game
+        uint64_t stalePauses = 0;   // pause resets dropped: already resumed
+        uint64_t resends = 0;       // see Resend()
+        // the output stage (see SetOutputRate)
+        uint64_t written = 0;       // commands handed to the sink
+        uint64_t merged = 0;        // replaced while waiting for a token
+        uint64_t dropped = 0;       // waited, then matched what was written
+    };
+
+    // SetSink, Resend and OnPaused may be called from any thread; the rest
+    // come from the game's thread
+    void SetSink(TriggerSink *sink);
+    // sends the last command again, e.g. once the transport has connected
+    void Resend();
+    // Caps the commands handed to the sink at perSecond (0: no cap), with
+    // bursts of up to burst. Commands over the cap wait for the next token
+    // on the scheduler (Scheduler.h), and a newer one replaces the one
+    // waiting.
+    void SetOutputRate(uint32_t perSecond, uint32_t burst);
+    Stats GetStats();
+    // forgets the player, weapon and ammo state; the game state is the FSM's
+    void Reset();
+
+    const void *CurrentPlayer();
+    bool IsCurrentPlayer(const void *player);
+
+    // idPlayer::OnWeaponSelected (weapon is never null)
+    void OnWeaponSelected(const void *weapon, const char *name);
+    // idPlayer::SelectWeaponByDeclExplicit, before and after the game's
+    // function (which may select the weapon in between)
+    void OnSelectWeaponByDecl(const void *weapon, const char *name);
+    void OnSelectWeaponByDeclDone();
+    // idPlayer::UpdateWeapon
+    void OnUpdateWeapon(const void *player);
+    // idInventoryItem_Ammo update; count is after the update. The current
+    // weapon running dry or getting ammo back switches the triggers.
+    void OnAmmoUpdate(const void *ammo, int count);
+    // idWeapon::SetFireMode; mode != 0 means the weapon mod is active
+    void OnFireModeSet(bool ok, uint32_t mode);
+    // idHands::Update, every frame
+    void OnHandsTick();
+    // the current player took damage (see IsCurrentPlayer)
+    void OnPlayerDamaged(bool isDead);
+    // idLoadScreen::LevelLoadCompleted; returns true when gameplay starts
+    // and the caller should report the player's weapon through
+    // OnLevelStartWeapon
+    bool OnLevelLoaded();
+    void OnLevelStartWeapon(const void *weapon, const char *name);
+    // the pause watcher detected a menu/pause
+    void OnPaused();
+}
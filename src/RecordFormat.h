@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of a recorded session (dualsensemod.rec), shared by the mod
+// and tools/replay. All fields are little-endian and unaligned.
+//
+//   FileHeader
+//   then a stream of records, each starting with a RecordKind byte:
+//     StringDef:  u16 id, u16 len, bytes
+//     Dropped:    u64 events dropped since the last Dropped record
+//     any event:  u64 tsc, then the event's payload:
+//       WeaponSelected, SelectWeaponByDecl, LevelStartWeapon:
+//                   u64 weapon, u16 name (string id, 0: null)
+//       UpdateWeapon:  u64 player
+//       AmmoUpdate:    u64 ammo, i32 count
+//       FireModeSet:   u8 ok, u32 mode
+//       PlayerDamaged: u8 dead
+//       others:        nothing
+//
+// Object pointers are only recorded as ids: the pipeline compares them but
+// never dereferences them.
+namespace RecordFormat {
+    constexpr char     kMagic[8] = {'D', 'S', 'M', 'R', 'E', 'C', 'O', 'R'};
+    constexpr uint32_t kVersion = 1;
+
+    enum RecordKind : uint8_t {
+        StringDef = 1,
+        Dropped   = 2,
+
+        WeaponSelected          = 16,
+        SelectWeaponByDecl      = 17,
+        SelectWeaponByDeclDone  = 18,
+        UpdateWeapon            = 19,
+        AmmoUpdate              = 20,
+        FireModeSet             = 21,
+        HandsTick               = 22,
+        PlayerDamaged           = 23,
+        LevelLoaded             = 24,
+        LevelStartWeapon        = 25,
+        Paused                  = 26,
+
+        FirstEvent = WeaponSelected,
+        LastEvent = Paused,
+    };
+
+    inline const char *ToString(uint8_t kind) {
+        switch (kind) {
+            case WeaponSelected:         return "WeaponSelected";
+            case SelectWeaponByDecl:     return "SelectWeaponByDecl";
+            case SelectWeaponByDeclDone: return "SelectWeaponByDeclDone";
+            case UpdateWeapon:           return "UpdateWeapon";
+            case AmmoUpdate:             return "AmmoUpdate";
+            case FireModeSet:            return "FireModeSet";
+            case HandsTick:              return "HandsTick";
+            case PlayerDamaged:          return "PlayerDamaged";
+            case LevelLoaded:            return "LevelLoaded";
+            case LevelStartWeapon:       return "LevelStartWeapon";
+            case Paused:                 return "Paused";
+            default:                     return "Unknown";
+        }
+    }
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        double   ticksPerUs;    // cycle counter calibration
+        uint64_t startTsc;      // cycle counter when recording started
+    };
+#pragma pack(pop)
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Recorder.h"
+#include "RingBuffer.h"
+#include "Tsc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct RecorderEvent {
+    uint64_t tsc;
+    uint64_t object;
+    uint32_t value;
+    uint16_t name;
+    uint8_t  kind;
+    uint8_t  flag;
+};
+
+static FILE *g_recordFile = nullptr;
+
+static RingBuffer<RecorderEvent, 4096> g_recordRing;
+static std::atomic<uint64_t> g_recordDropped{0};
+
+// Weapon names are few and only show up on weapon switches, so a plain
+// mutex-protected map is enough; definitions are written out before any
+// queued event that may refer to them
+static std::mutex g_namesMutex;
+static std::unordered_map<std::string, uint16_t> g_names;
+static std::vector<char> g_pendingNames;
+
+template <typename T>
+static void Put(std::vector<char>& buf, const T& value) {
+    const char *p = reinterpret_cast<const char *>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+static uint16_t InternName(const char *name) {
+    if (!name)
+        return 0;
+    std::lock_guard<std::mutex> lock(g_namesMutex);
+    auto it = g_names.find(name);
+    if (it != g_names.end())
+        return it->second;
+    if (g_names.size() >= UINT16_MAX)
+        return 0;
+
+    const uint16_t id = (uint16_t)(g_names.size() + 1);
+    g_names.emplace(name, id);
+    const uint16_t len = (uint16_t)strnlen(name, UINT16_MAX);
+    Put(g_pendingNames, RecordFormat::StringDef);
+    Put(g_pendingNames, id);
+    Put(g_pendingNames, len);
+    g_pendingNames.insert(g_pendingNames.end(), name, name + len);
+    return id;
+}
+
+namespace Recorder {
+
+    std::atomic<bool> g_recording{false};
+
+    bool Open(const char *path) {
+        g_recordFile = fopen(path, "wb");
+        if (!g_recordFile)
+            return false;
+
+        RecordFormat::FileHeader header = {};
+        memcpy(header.magic, RecordFormat::kMagic, sizeof(header.magic));
+        header.version = RecordFormat::kVersion;
+        header.ticksPerUs = Tsc::TicksPerUs();
+        header.startTsc = Tsc::Now();
+        fwrite(&header, sizeof(header), 1, g_recordFile);
+        fflush(g_recordFile);
+        g_recording.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void Close() {
+        if (!g_recordFile)
+            return;
+        g_recording.store(false, std::memory_order_relaxed);
+        Flush();
+        fclose(g_recordFile);
+        g_recordFile = nullptr;
+    }
+
+    void Flush() {
+        if (!g_recordFile)
+            return;
+
+        std::vector<char> buf;
+        {
+            std::lock_guard<std::mutex> lock(g_namesMutex);
+            buf.swap(g_pendingNames);
+        }
+
+        while (g_recordRing.TryPop([&](const RecorderEvent& e) {
+            Put(buf, e.kind);
+            Put(buf, e.tsc);
+            switch (e.kind) {
+                case RecordFormat::WeaponSelected:
+                case RecordFormat::SelectWeaponByDecl:
+                case RecordFormat::LevelStartWeapon:
+                    Put(buf, e.object);
+                    Put(buf, e.name);
+                    break;
+                case RecordFormat::UpdateWeapon:
+                    Put(buf, e.object);
+                    break;
+                case RecordFormat::AmmoUpdate:
+                    Put(buf, e.object);
+                    Put(buf, (int32_t)e.value);
+                    break;
+                case RecordFormat::FireModeSet:
+                    Put(buf, e.flag);
+                    Put(buf, e.value);
+                    break;
+                case RecordFormat::PlayerDamaged:
+                    Put(buf, e.flag);
+                    break;
+                default:
+                    break;
+            }
+        }));
+
+        uint64_t dropped = g_recordDropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            Put(buf, RecordFormat::Dropped);
+            Put(buf, dropped);
+        }
+
+        if (!buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), g_recordFile);
+            fflush(g_recordFile);
+        }
+    }
+
+    void Record(RecordFormat::RecordKind kind, const void *object,
+            uint32_t value, uint8_t flag, const char *name) {
+        if (!Enabled())
+            return;
+        const uint16_t nameId = InternName(name);
+        const uint64_t tsc = Tsc::Now();
+        if (!g_recordRing.TryPush([&](RecorderEvent& e) {
+            e.tsc = tsc;
+            e.object = (uint64_t)(uintptr_t)object;
+            e.value = value;
+            e.name = nameId;
+            e.kind = kind;
+            e.flag = flag;
+        }))
+            g_recordDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include "RecordFormat.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Session recorder.
+//
+// When recording (record=true), every event the pipeline receives is queued
+// with a cycle counter timestamp and its decoded values into a lock-free
+// ring, and written out by the log writer thread in the RecordFormat layout.
+// tools/replay feeds such a file back through the pipeline without the game.
+namespace Recorder {
+
+    extern std::atomic<bool> g_recording;
+
+    inline bool Enabled() {
+        return g_recording.load(std::memory_order_relaxed);
+    }
+
+    bool Open(const char *path);
+    void Close();
+    // writes queued events to disk; called periodically by the log writer
+    void Flush();
+
+    // object: the event's opaque object id (weapon, player, ammo), value:
+    // ammo count / fire mode, flag: fire mode set ok / player dead, name:
+    // weapon name (may be null)
+    void Record(RecordFormat::RecordKind kind, const void *object = nullptr,
+            uint32_t value = 0, uint8_t flag = 0, const char *name = nullptr);
+}
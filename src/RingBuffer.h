@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer ring (D. Vyukov's bounded MPMC queue).
+//
+// Producers never block: TryPush fails when the ring is full and it's up to
+// the caller to account for the drop. Records are filled and consumed in
+// place, so there's no extra copy of the (potentially large) payload.
+template <typename T, size_t Capacity>
+class RingBuffer
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+            "RingBuffer capacity must be a power of two");
+
+public:
+    RingBuffer() {
+        for (size_t i = 0; i < Capacity; i++)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // fill: void(T&), called on the claimed slot before it's published
+    template <typename F>
+    bool TryPush(F&& fill) {
+        Cell *cell;
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & (Capacity - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consume: void(const T&), called before the slot is handed back
+    template <typename F>
+    bool TryPop(F&& consume) {
+        Cell *cell;
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & (Capacity - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        consume(cell->data);
+        cell->seq.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    // approximate; only meant for wake-up heuristics and stats
+    size_t Size() const {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    // keep producers and the consumer off each other's cache lines
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) Cell m_cells[Capacity];
+};
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Scheduler.h"
+#include "Timeline.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using Scheduler::Clock;
+using Scheduler::TaskId;
+
+namespace {
+    struct Task {
+        std::function<void()> run;
+        Clock::duration period{};       // 0: one-shot
+        Clock::time_point due;
+    };
+
+    struct Deadline {
+        Clock::time_point due;
+        TaskId id;
+
+        bool operator>(const Deadline& other) const {
+            return due > other.due;
+        }
+    };
+
+    // Never destroyed: tasks (and the thread) may still be around while
+    // static destructors run at process exit
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;         // new deadlines, stop
+        std::condition_variable taskDone;   // for Cancel()
+        std::priority_queue<Deadline, std::vector<Deadline>,
+            std::greater<Deadline>> heap;
+        // cancelled tasks are only dropped from here; their stale heap
+        // entries are skipped when they come up
+        std::unordered_map<TaskId, Task> tasks;
+        TaskId nextId = 1;
+        TaskId running = 0;
+        std::thread::id threadId;
+        bool started = false;
+        bool stop = false;
+        bool done = false;
+        Scheduler::Stats stats;
+    };
+
+    State& S() {
+        static State *state = new State;
+        return *state;
+    }
+}
+
+static void SchedulerThread() {
+    Timeline::NameThread("scheduler");
+    State& s = S();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (!s.stop) {
+        if (s.heap.empty()) {
+            s.cv.wait(lock);
+            s.stats.wakeups++;
+            continue;
+        }
+
+        const Deadline next = s.heap.top();
+        auto it = s.tasks.find(next.id);
+        if (it == s.tasks.end() || it->second.due != next.due) {
+            // cancelled or moved by RunNow
+            s.heap.pop();
+            continue;
+        }
+        if (Clock::now() < next.due) {
+            s.cv.wait_until(lock, next.due);
+            s.stats.wakeups++;
+            continue;
+        }
+
+        s.heap.pop();
+        s.running = next.id;
+        s.stats.runs++;
+        // copied: the task may cancel itself or schedule others
+        std::function<void()> run = it->second.run;
+        lock.unlock();
+        run();
+        lock.lock();
+        s.running = 0;
+
+        it = s.tasks.find(next.id);
+        if (it != s.tasks.end()) {
+            Task& task = it->second;
+            if (task.period.count()) {
+                const Clock::time_point now = Clock::now();
+                task.due += task.period;
+                if (task.due <= now)
+                    task.due = now + task.period;
+                s.heap.push({ task.due, next.id });
+            } else {
+                s.tasks.erase(it);
+            }
+        }
+        s.taskDone.notify_all();
+    }
+    s.done = true;
+    s.taskDone.notify_all();
+}
+
+static TaskId Add(Clock::time_point due, Clock::duration period,
+        std::function<void()> run) {
+    State& s = S();
+    TaskId id;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        id = s.nextId++;
+        s.tasks.emplace(id, Task{ std::move(run), period, due });
+        earliest = s.heap.empty() || due < s.heap.top().due;
+        s.heap.push({ due, id });
+    }
+    if (earliest)
+        s.cv.notify_one();
+    return id;
+}
+
+namespace Scheduler {
+
+    void Start() {
+        State& s = S();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.started && !s.done) {
+            // Stopped but not gone yet: the thread only leaves its loop (and
+            // sets done) under the lock, so it hasn't seen stop yet and
+            // carries on instead of exiting behind our back
+            s.stop = false;
+            return;
+        }
+        s.started = true;
+        s.stop = false;
+        s.done = false;
+        // detached: joining from DllMain deadlocks, see Stop()
+        std::thread thread(SchedulerThread);
+        s.threadId = thread.get_id();
+        thread.detach();
+    }
+
+    bool Stop() {
+        State& s = S();
+        std::unique_lock<std::mutex> lock(s.mutex);
+        if (!s.started)
+            return true;
+        s.stop = true;
+        s.cv.notify_one();
+        if (OnSchedulerThread())
+            return true;
+        return s.taskDone.wait_for(lock, std::chrono::seconds(1),
+                [&s] { return s.done; });
+    }
+
+    TaskId At(Clock::time_point when, std::function<void()> task) {
+        return Add(when, Clock::duration::zero(), std::move(task));
+    }
+
+    TaskId After(Clock::duration delay, std::function<void()> task) {
+        return Add(Clock::now() + delay, Clock::duration::zero(),
+                std::move(task));
+    }
+
+    TaskId Every(Clock::duration period, std::function<void()> task) {
+        return Add(Clock::now() + period, period, std::move(task));
+    }
+
+    void RunNow(TaskId id) {
+        State& s = S();
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.tasks.find(id);
+            if (it == s.tasks.end() || s.running == id)
+                return;
+            it->second.due = Clock::now();
+            s.heap.push({ it->second.due, id });
+        }
+        s.cv.notify_one();
+    }
+
+    bool Cancel(TaskId id) {
+        State& s = S();
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.tasks.erase(id);
+        if (s.running != id || OnSchedulerThread())
+            return true;
+        return s.taskDone.wait_for(lock, std::chrono::seconds(1),
+                [&s, id] { return s.running != id || s.done; });
+    }
+
+    bool OnSchedulerThread() {
+        return std::this_thread::get_id() == S().threadId;
+    }
+
+    Stats GetStats() {
+        State& s = S();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.stats;
+    }
+}
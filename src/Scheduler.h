@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// The mod's one background thread.
+//
+// Everything the mod does off the game's threads (pause sampling, log
+// flushing, connecting to the DualSensitive service, periodic stats) is a
+// task on a single timer heap, so the mod competes with the game's workers
+// with one mostly-sleeping thread and wakes up exactly when the next
+// deadline is due. Tasks run one at a time, outside the scheduler's lock;
+// they must not block for long, as everything else waits behind them (the
+// one-off service launch, which waits on schtasks, gets its own thread).
+namespace Scheduler {
+    using Clock = std::chrono::steady_clock;
+    // 0 is never a valid id
+    using TaskId = uint64_t;
+
+    // starts the thread; no-op if it's already running, including one that
+    // was asked to Stop() but hasn't exited yet (it keeps running)
+    void Start();
+    // Runs nothing more and lets the thread exit. Doesn't join it, as that
+    // deadlocks under the loader lock (DLL_PROCESS_DETACH): waits up to a
+    // second for it to finish the task at hand instead. Returns false if it
+    // didn't.
+    bool Stop();
+
+    TaskId At(Clock::time_point when, std::function<void()> task);
+    TaskId After(Clock::duration delay, std::function<void()> task);
+    // first run one period from now; a run that's late doesn't cause a burst
+    // of catch-up runs
+    TaskId Every(Clock::duration period, std::function<void()> task);
+
+    // Runs a pending task right away (e.g. a flush that shouldn't wait for
+    // its period); no-op if it's unknown or already running
+    void RunNow(TaskId id);
+    // Once this returns the task won't start again, and isn't running
+    // (unless called by the task itself). Returns false if it was still
+    // running after a second.
+    bool Cancel(TaskId id);
+
+    bool OnSchedulerThread();
+
+    struct Stats {
+        uint64_t wakeups = 0;   // times the thread woke up
+        uint64_t runs = 0;      // tasks run
+    };
+    Stats GetStats();
+}
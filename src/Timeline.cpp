@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Timeline.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct TimelineEvent {
+    uint64_t tsc;
+    uint64_t duration;      // ticks; complete events only
+    const char *category;
+    const char *name;
+    uint32_t tid;
+    char phase;             // 'X': complete (span), 'i': instant
+    char detail[Timeline::kMaxDetail];
+};
+
+// Events are claimed with a single fetch_add and the oldest ones are simply
+// overwritten. Each slot carries a sequence number (0 while being written,
+// index + 1 once published) so Export() can skip slots torn by a concurrent
+// writer instead of stopping the world.
+struct TimelineSlot {
+    std::atomic<uint64_t> seq{0};
+    TimelineEvent event;
+};
+
+static constexpr size_t kTimelineSlots = 8192;
+static TimelineSlot g_timeline[kTimelineSlots];
+static std::atomic<uint64_t> g_timelineNext{0};
+static uint64_t g_timelineStartTsc = 0;
+
+static std::mutex g_threadNamesMutex;
+static std::vector<std::pair<uint32_t, std::string>> g_threadNames;
+
+static uint32_t CurrentThreadId() {
+    thread_local uint32_t tid =
+#ifdef _WIN32
+        (uint32_t)GetCurrentThreadId();
+#else
+        (uint32_t)syscall(SYS_gettid);
+#endif
+    return tid;
+}
+
+static void Push(char phase, const char *category, const char *name,
+        uint64_t tsc, uint64_t duration, const char *detail) {
+    const uint64_t index =
+        g_timelineNext.fetch_add(1, std::memory_order_relaxed);
+    TimelineSlot& slot = g_timeline[index & (kTimelineSlots - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TimelineEvent& e = slot.event;
+    e.tsc = tsc;
+    e.duration = duration;
+    e.category = category;
+    e.name = name;
+    e.tid = CurrentThreadId();
+    e.phase = phase;
+    if (detail) {
+        strncpy(e.detail, detail, sizeof(e.detail) - 1);
+        e.detail[sizeof(e.detail) - 1] = '\0';
+    } else {
+        e.detail[0] = '\0';
+    }
+
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+static void WriteJsonString(FILE *f, const char *str) {
+    fputc('"', f);
+    for (; *str; str++) {
+        const unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+namespace Timeline {
+
+    std::atomic<bool> g_enabled{false};
+
+    void Enable() {
+        // calibrate now rather than on the first export
+        Tsc::TicksPerUs();
+        g_timelineStartTsc = Tsc::Now();
+        g_enabled.store(true, std::memory_order_release);
+    }
+
+    void NameThread(const char *name) {
+        std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+        g_threadNames.emplace_back(CurrentThreadId(), name);
+    }
+
+    void Instant(const char *category, const char *name, const char *detail) {
+        if (Enabled())
+            Push('i', category, name, Tsc::Now(), 0, detail);
+    }
+
+    void Complete(const char *category, const char *name, uint64_t startTsc,
+            uint64_t durationTicks, const char *detail) {
+        if (Enabled())
+            Push('X', category, name, startTsc, durationTicks, detail);
+    }
+
+    bool Export(const char *path) {
+        if (!Enabled())
+            return false;
+
+        std::vector<TimelineEvent> events;
+        events.reserve(kTimelineSlots);
+        const uint64_t next = g_timelineNext.load(std::memory_order_acquire);
+        const uint64_t first = next > kTimelineSlots ? next - kTimelineSlots : 0;
+        for (uint64_t i = first; i < next; i++) {
+            TimelineSlot& slot = g_timeline[i & (kTimelineSlots - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != i + 1)
+                continue;
+            TimelineEvent e = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != i + 1)
+                continue;   // overwritten while we were copying it
+            events.push_back(e);
+        }
+        // spans are recorded when they end; order everything by start time
+        std::sort(events.begin(), events.end(),
+                [](const TimelineEvent& a, const TimelineEvent& b) {
+                    return a.tsc < b.tsc;
+                });
+
+        FILE *f = fopen(path, "w");
+        if (!f)
+            return false;
+
+        const double ticksPerUs = Tsc::TicksPerUs();
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+        fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\","
+                "\"args\":{\"name\":\"DOOM (2016) DualsenseMod\"}}");
+        {
+            std::lock_guard<std::mutex> lock(g_threadNamesMutex);
+            for (auto& [tid, name] : g_threadNames) {
+                fprintf(f, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                        "\"name\":\"thread_name\",\"args\":{\"name\":", tid);
+                WriteJsonString(f, name.c_str());
+                fputs("}}", f);
+            }
+        }
+        for (const TimelineEvent& e : events) {
+            const double ts =
+                (double)(int64_t)(e.tsc - g_timelineStartTsc) / ticksPerUs;
+            fprintf(f, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,",
+                    e.phase, e.tid, ts);
+            if (e.phase == 'X')
+                fprintf(f, "\"dur\":%.3f,", e.duration / ticksPerUs);
+            else
+                fputs("\"s\":\"t\",", f);
+            fputs("\"cat\":", f);
+            WriteJsonString(f, e.category);
+            fputs(",\"name\":", f);
+            WriteJsonString(f, e.name);
+            if (e.detail[0]) {
+                fputs(",\"args\":{\"detail\":", f);
+                WriteJsonString(f, e.detail);
+                fputc('}', f);
+            }
+            fputc('}', f);
+        }
+        fputs("\n]}\n", f);
+        fclose(f);
+        return true;
+    }
+}
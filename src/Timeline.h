@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include "Tsc.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Event timeline (flight recorder).
+//
+// When enabled (timeline=true), hooks, game state transitions and trigger
+// sends are recorded as spans and instant events, with the thread they ran
+// on, into a fixed-size in-memory ring that keeps the most recent events.
+// Export() writes the ring as Chrome trace JSON, which chrome://tracing and
+// ui.perfetto.dev open directly.
+namespace Timeline {
+
+    // names and categories must be string literals (or otherwise outlive
+    // the ring); details are copied and truncated to kMaxDetail - 1 chars
+    static constexpr int kMaxDetail = 48;
+
+    extern std::atomic<bool> g_enabled;
+
+    inline bool Enabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void Enable();
+    // names the calling thread in exported timelines
+    void NameThread(const char *name);
+
+    void Instant(const char *category, const char *name,
+            const char *detail = nullptr);
+    void Complete(const char *category, const char *name, uint64_t startTsc,
+            uint64_t durationTicks, const char *detail = nullptr);
+
+    // snapshot of the ring, oldest event first; safe to call while other
+    // threads are still recording
+    bool Export(const char *path);
+
+    // records a span from construction to destruction, if enabled
+    class Span
+    {
+    public:
+        Span(const char *category, const char *name,
+                const char *detail = nullptr)
+            : m_category(category), m_name(name), m_detail(detail),
+              m_start(Enabled() ? Tsc::Now() : 0) {}
+
+        ~Span() {
+            if (m_start)
+                Complete(m_category, m_name, m_start, Tsc::Now() - m_start,
+                        m_detail);
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char *m_category;
+        const char *m_name;
+        const char *m_detail;
+        uint64_t m_start;
+    };
+}
+
+#define TIMELINE_CONCAT_(a, b) a##b
+#define TIMELINE_CONCAT(a, b) TIMELINE_CONCAT_(a, b)
+#define TIMELINE_SPAN(category, ...) \
+    Timeline::Span TIMELINE_CONCAT(_timelineSpan, __LINE__)(category, __VA_ARGS__)
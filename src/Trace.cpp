@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "Trace.h"
+#include "RingBuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static FILE *g_traceFile = nullptr;
+
+static RingBuffer<Trace::Record, 4096> g_traceRing;
+static std::atomic<uint64_t> g_traceDropped{0};
+
+// Site and string definitions are rare (once per site / distinct string), so
+// they go through a mutex-protected buffer that is written out before any
+// queued event that may refer to them
+static std::mutex g_defsMutex;
+static std::vector<char> g_pendingDefs;
+static uint16_t g_nextSite = 1;
+static uint32_t g_nextStringId = 1;
+
+struct InternEntry {
+    std::atomic<uint32_t> id{0};    // 0: free slot; published last
+    uint64_t hash = 0;
+    const char *str = nullptr;
+};
+
+static constexpr size_t kInternSlots = 2048;
+static constexpr size_t kInternLimit = kInternSlots * 3 / 4;
+static InternEntry g_interned[kInternSlots];
+
+template <typename T>
+static void Put(std::vector<char>& buf, const T& value) {
+    const char *p = reinterpret_cast<const char *>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+static void PutString(std::vector<char>& buf, const char *str) {
+    uint16_t len = (uint16_t)strnlen(str, UINT16_MAX);
+    Put(buf, len);
+    buf.insert(buf.end(), str, str + len);
+}
+
+static uint64_t HashString(const char *str) {
+    uint64_t h = 1469598103934665603ull;    // FNV-1a
+    for (; *str; str++) {
+        h ^= (uint8_t)*str;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+namespace Trace {
+
+    bool Open(const char *path) {
+        g_traceFile = fopen(path, "wb");
+        if (!g_traceFile)
+            return false;
+
+        TraceFormat::FileHeader header = {};
+        memcpy(header.magic, TraceFormat::kMagic, sizeof(header.magic));
+        header.version = TraceFormat::kVersion;
+        header.ticksPerUs = Tsc::TicksPerUs();
+        header.startTsc = Tsc::Now();
+        fwrite(&header, sizeof(header), 1, g_traceFile);
+        fflush(g_traceFile);
+        return true;
+    }
+
+    void Close() {
+        if (!g_traceFile)
+            return;
+        Flush();
+        fclose(g_traceFile);
+        g_traceFile = nullptr;
+    }
+
+    void Flush() {
+        if (!g_traceFile)
+            return;
+
+        // events first: a site or string is defined before any event that
+        // refers to it is queued, so whatever definitions are pending once
+        // these are out of the ring cover all of them
+        std::vector<char> events;
+        while (g_traceRing.TryPop([&](const Record& r) {
+            Put(events, TraceFormat::Event);
+            Put(events, r.site);
+            Put(events, r.tsc);
+            Put(events, r.nargs);
+            for (uint8_t i = 0; i < r.nargs; i++) {
+                Put(events, r.types[i]);
+                Put(events, r.args[i]);
+            }
+        }));
+
+        std::vector<char> buf;
+        {
+            std::lock_guard<std::mutex> lock(g_defsMutex);
+            buf.swap(g_pendingDefs);
+        }
+        buf.insert(buf.end(), events.begin(), events.end());
+
+        uint64_t dropped = g_traceDropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            Put(buf, TraceFormat::Dropped);
+            Put(buf, dropped);
+        }
+
+        if (!buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), g_traceFile);
+            fflush(g_traceFile);
+        }
+    }
+
+    uint16_t RegisterSite(const char *file, int line, const char *format) {
+        std::lock_guard<std::mutex> lock(g_defsMutex);
+        uint16_t site = g_nextSite++;
+        Put(g_pendingDefs, TraceFormat::SiteDef);
+        Put(g_pendingDefs, site);
+        Put(g_pendingDefs, (uint32_t)line);
+        PutString(g_pendingDefs, file);
+        PutString(g_pendingDefs, format);
+        return site;
+    }
+
+    uint32_t Intern(const char *str) {
+        if (!str)
+            return 0;
+
+        const uint64_t hash = HashString(str);
+        for (size_t i = 0; i < kInternSlots; i++) {
+            InternEntry& e = g_interned[(hash + i) & (kInternSlots - 1)];
+            uint32_t id = e.id.load(std::memory_order_acquire);
+            if (!id)
+                break;
+            if (e.hash == hash && !strcmp(e.str, str))
+                return id;
+        }
+
+        // first sighting
+        std::lock_guard<std::mutex> lock(g_defsMutex);
+        size_t slot = 0;
+        for (size_t i = 0; i < kInternSlots; i++) {
+            slot = (hash + i) & (kInternSlots - 1);
+            InternEntry& e = g_interned[slot];
+            uint32_t id = e.id.load(std::memory_order_relaxed);
+            if (!id)
+                break;
+            // someone else got here first
+            if (e.hash == hash && !strcmp(e.str, str))
+                return id;
+        }
+        if (g_nextStringId > kInternLimit)
+            return 0;
+
+        InternEntry& e = g_interned[slot];
+        uint32_t id = g_nextStringId++;
+        e.hash = hash;
+        e.str = strdup(str);
+        e.id.store(id, std::memory_order_release);
+
+        Put(g_pendingDefs, TraceFormat::StringDef);
+        Put(g_pendingDefs, id);
+        PutString(g_pendingDefs, str);
+        return id;
+    }
+
+    void Commit(const Record& record) {
+        if (!g_traceRing.TryPush([&](Record& r) { r = record; }))
+            g_traceDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include "TraceFormat.h"
+#include "Tsc.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Binary deferred-format trace log.
+//
+// Every _LOGD site registers its format string once; after that, the hot path
+// only stores the site id, a cycle counter timestamp and the raw arguments
+// (strings are interned) into a lock-free ring. Formatting happens offline
+// with tools/trace-decode.
+namespace Trace {
+
+    struct Record {
+        uint64_t tsc;
+        uint16_t site;
+        uint8_t  nargs;
+        uint8_t  types[TraceFormat::kMaxArgs];
+        uint64_t args[TraceFormat::kMaxArgs];
+    };
+
+    bool Open(const char *path);
+    void Close();
+    // writes queued records to disk; called periodically by the log writer
+    void Flush();
+
+    uint16_t RegisterSite(const char *file, int line, const char *format);
+    // string -> id, by content; the first sighting of a string costs a lock
+    uint32_t Intern(const char *str);
+    void Commit(const Record& record);
+
+    template <typename... Args>
+    inline const char *FormatOf(const char *format, const Args&...) {
+        return format;
+    }
+
+    template <typename T>
+    inline void Encode(uint8_t& type, uint64_t& value, const T& arg) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, char*> ||
+                std::is_same_v<U, const char*>) {
+            type = TraceFormat::Str;
+            value = Intern(arg);
+        } else if constexpr (std::is_pointer_v<U> ||
+                std::is_null_pointer_v<U>) {
+            type = TraceFormat::Ptr;
+            value = (uint64_t)(uintptr_t)arg;
+        } else if constexpr (std::is_floating_point_v<U>) {
+            type = TraceFormat::Double;
+            double d = (double)arg;
+            memcpy(&value, &d, sizeof(value));
+        } else if constexpr (std::is_signed_v<U>) {
+            type = TraceFormat::Int;
+            value = (uint64_t)(int64_t)arg;
+        } else {
+            type = TraceFormat::UInt;
+            value = (uint64_t)arg;
+        }
+    }
+
+    template <typename... Args>
+    inline void Write(uint16_t site, const char *, const Args&... args) {
+        static_assert(sizeof...(Args) <= TraceFormat::kMaxArgs,
+                "too many arguments for a trace record");
+        Record r;
+        r.tsc = Tsc::Now();
+        r.site = site;
+        r.nargs = 0;
+        ((Encode(r.types[r.nargs], r.args[r.nargs], args), r.nargs++), ...);
+        Commit(r);
+    }
+}
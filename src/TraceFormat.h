@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of the binary trace log (dualsensemod.trace), shared by the
+// mod and tools/trace-decode. All fields are little-endian and unaligned.
+//
+//   TraceFileHeader
+//   then a stream of records, each starting with a TraceRecordKind byte:
+//     SiteDef:   u16 site, u32 line, u16 len, file, u16 len, format
+//     StringDef: u32 id, u16 len, bytes
+//     Event:     u16 site, u64 tsc, u8 nargs, nargs * (u8 type, u64 value)
+//     Dropped:   u64 events dropped since the last Dropped record
+namespace TraceFormat {
+    constexpr char     kMagic[8] = {'D', 'S', 'M', 'T', 'R', 'A', 'C', 'E'};
+    constexpr uint32_t kVersion = 1;
+    constexpr int      kMaxArgs = 8;
+
+    enum RecordKind : uint8_t {
+        SiteDef   = 1,
+        StringDef = 2,
+        Event     = 3,
+        Dropped   = 4,
+    };
+
+    enum ArgType : uint8_t {
+        Int    = 1,     // sign-extended to 64 bits
+        UInt   = 2,
+        Double = 3,     // IEEE-754 bits
+        Ptr    = 4,
+        Str    = 5,     // interned string id (0: null)
+    };
+
+#pragma pack(push, 1)
+    struct FileHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        double   ticksPerUs;    // cycle counter calibration
+        uint64_t startTsc;      // cycle counter when the trace was opened
+    };
+#pragma pack(pop)
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "TriggerProfiles.h"
+#include "IniFile.h"
+#include "Logger.h"
+#include "Scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <filesystem>
+#include <mutex>
+
+#define WEAPON_DECL_PREFIX "weapon/zion/player/sp/"
+
+namespace TriggerProfiles::detail {
+    std::atomic<const Table *> g_table{nullptr};
+    std::atomic<uint32_t> g_epoch{0};
+    std::atomic<uint32_t> g_readers[2];
+}
+
+using namespace TriggerProfiles::detail;
+using TriggerProfiles::Table;
+
+// Everything below is only touched by Start() and then the poll task
+static std::string g_path;
+static TriggerProfiles::Resolver g_resolve = nullptr;
+static void (*g_onReload)() = nullptr;
+static Scheduler::TaskId g_pollTask = 0;
+static std::filesystem::file_time_type g_lastWrite;
+static uintmax_t g_lastSize = 0;
+static bool g_seen = false;
+// a change is only loaded once it has stayed the same for a whole poll
+// interval, so that we don't catch the editor halfway through saving
+static std::filesystem::file_time_type g_pendingWrite;
+static uintmax_t g_pendingSize = 0;
+
+// The table replaced by the last publish, and the grace period its readers
+// are counted in. Until they've all left, it can't be freed and no other
+// table can be published: the counter is shared with the period after next.
+static const Table *g_retired = nullptr;
+static uint32_t g_retiredParity = 0;
+static bool g_draining = false;
+
+static std::mutex g_statsMutex;
+static TriggerProfiles::Stats g_stats;
+
+static bool Reclaim() {
+    if (!g_draining)
+        return true;
+    if (g_readers[g_retiredParity].load(std::memory_order_acquire))
+        return false;
+    delete g_retired;
+    g_retired = nullptr;
+    g_draining = false;
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    g_stats.freed++;
+    return true;
+}
+
+static void Publish(const Table *table) {
+    g_retired = g_table.exchange(table);
+    // readers that got in before this ended may hold the old table; those
+    // that come after only see the new one
+    g_retiredParity = g_epoch.fetch_add(1) & 1;
+    g_draining = true;
+    Reclaim();
+}
+
+// "profile Galloping 1 3 1 6 40" / "mode Pulse_AB 18, 197, 35"
+static bool ParseTrigger(std::string_view value,
+        TriggerProfiles::Resolver resolve, TriggerProfiles::Trigger& out,
+        std::string& error) {
+    std::vector<std::string> tokens;
+    size_t pos = 0;
+    while (pos < value.size()) {
+        const size_t begin = value.find_first_not_of(" \t,", pos);
+        if (begin == std::string_view::npos)
+            break;
+        const size_t end = value.find_first_of(" \t,", begin);
+        tokens.emplace_back(value.substr(begin, end - begin));
+        pos = end == std::string_view::npos ? value.size() : end;
+    }
+
+    if (tokens.size() < 2) {
+        error = "expected 'profile <name> [extras]' or 'mode <name> [extras]'";
+        return false;
+    }
+    if (IniFile::IEquals(tokens[0], "profile")) {
+        out.isCustomTrigger = false;
+    } else if (IniFile::IEquals(tokens[0], "mode")) {
+        out.isCustomTrigger = true;
+    } else {
+        error = "'" + tokens[0] + "' is neither profile nor mode";
+        return false;
+    }
+    if (!resolve(tokens[1], out.isCustomTrigger, out.value)) {
+        error = "unknown trigger " +
+            std::string(out.isCustomTrigger ? "mode" : "profile") +
+            " '" + tokens[1] + "'";
+        return false;
+    }
+
+    out.extras.clear();
+    for (size_t i = 2; i < tokens.size(); i++) {
+        char *end = nullptr;
+        const unsigned long n = strtoul(tokens[i].c_str(), &end, 0);
+        if (*end || tokens[i][0] == '-' || n > 255) {
+            error = "extra '" + tokens[i] + "' is not a number in 0-255";
+            return false;
+        }
+        out.extras.push_back((uint8_t)n);
+    }
+    return true;
+}
+
+namespace TriggerProfiles {
+
+    bool Parse(const std::string& text, Resolver resolve, Table& out,
+            std::string& error) {
+        out.clear();
+        IniFile ini;
+        ini.Parse(text);
+        if (!ini.Errors().empty()) {
+            const IniFile::Error& e = ini.Errors().front();
+            error = "line " + std::to_string(e.line) + ": " + e.message;
+            return false;
+        }
+
+        for (const IniFile::Section& section : ini.Sections()) {
+            auto fail = [&](int line, const std::string& what) {
+                error = "line " + std::to_string(line) + ": " + what;
+                return false;
+            };
+            const std::string name(section.name);
+            if (name.empty())
+                return fail(section.line, "empty section name");
+            const std::string weaponId =
+                name.find('/') == std::string::npos ?
+                WEAPON_DECL_PREFIX + name : name;
+            auto inserted = out.emplace(weaponId, Triggers{});
+            if (!inserted.second)
+                return fail(section.line, "[" + name + "] appears twice");
+            Triggers& triggers = inserted.first->second;
+
+            bool hasL2 = false, hasR2 = false;
+            for (const IniFile::Entry& entry : section.entries) {
+                Trigger *trigger;
+                if (IniFile::IEquals(entry.key, "L2")) {
+                    trigger = &triggers.L2;
+                    hasL2 = true;
+                } else if (IniFile::IEquals(entry.key, "R2")) {
+                    trigger = &triggers.R2;
+                    hasR2 = true;
+                } else {
+                    return fail(entry.line, "unknown key '" +
+                            std::string(entry.key) + "'");
+                }
+                std::string what;
+                if (!ParseTrigger(entry.value, resolve, *trigger, what))
+                    return fail(entry.line, what);
+            }
+            if (!hasL2 || !hasR2) {
+                error = "[" + name + "] needs both L2 and R2";
+                return false;
+            }
+        }
+
+        if (out.empty()) {
+            // most likely truncated; no weapon would have triggers
+            error = "no weapon sections";
+            return false;
+        }
+        return true;
+    }
+
+    static void Poll(bool settle) {
+        if (!Reclaim())
+            return;     // retried on the next tick
+
+        std::error_code ec;
+        const auto lastWrite = std::filesystem::last_write_time(g_path, ec);
+        if (ec)
+            return;     // not there (yet); keep what we have
+        const uintmax_t size = std::filesystem::file_size(g_path, ec);
+        if (ec || (g_seen && lastWrite == g_lastWrite && size == g_lastSize))
+            return;
+        if (settle && (lastWrite != g_pendingWrite || size != g_pendingSize)) {
+            g_pendingWrite = lastWrite;
+            g_pendingSize = size;
+            return;
+        }
+
+        FILE *f = fopen(g_path.c_str(), "rb");
+        if (!f)
+            return;     // e.g. the editor still has it locked
+        std::string text;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            text.append(buf, n);
+        fclose(f);
+
+        g_seen = true;
+        g_lastWrite = lastWrite;
+        g_lastSize = size;
+
+        Table *table = new Table;
+        std::string error;
+        if (!Parse(text, g_resolve, *table, error)) {
+            delete table;
+            _LOGW(LOG_TRANSPORT, "%s rejected, keeping the current triggers: "
+                    "%s", g_path.c_str(), error.c_str());
+            std::lock_guard<std::mutex> lock(g_statsMutex);
+            g_stats.rejected++;
+            return;
+        }
+
+        const size_t weapons = table->size();
+        Publish(table);
+        Stats stats;
+        {
+            std::lock_guard<std::mutex> lock(g_statsMutex);
+            g_stats.reloads++;
+            stats = g_stats;
+        }
+        _LOG("Trigger profiles loaded from %s (%zu weapons; reloads: %llu, "
+                "rejected: %llu, tables freed: %llu)",
+                g_path.c_str(), weapons,
+                (unsigned long long)stats.reloads,
+                (unsigned long long)stats.rejected,
+                (unsigned long long)stats.freed);
+        if (g_onReload)
+            g_onReload();
+    }
+
+    void Start(const char *path, Table defaults, Resolver resolve,
+            void (*onReload)(), std::chrono::milliseconds pollInterval) {
+        if (g_pollTask)
+            return;
+        g_path = path;
+        g_resolve = resolve;
+        g_onReload = nullptr;
+        Publish(new Table(std::move(defaults)));
+        // nothing can have been sent with the file's triggers yet
+        Poll(false);
+        g_onReload = onReload;
+        g_pollTask = Scheduler::Every(pollInterval, [] { Poll(true); });
+    }
+
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lock(g_statsMutex);
+        return g_stats;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Per-weapon adaptive trigger settings, loaded from a profiles file and
+// reloaded whenever it changes.
+//
+// The file is polled from a scheduler task (Scheduler.h); a changed file is
+// parsed and validated there, and a table that passes replaces the current
+// one with a single pointer swap. A file with any error is rejected as a
+// whole and the table in use stays. Readers (the transport sending a
+// weapon's triggers) take no locks: they only mark themselves in the
+// current grace period, and a replaced table is freed once every reader that
+// may still hold it has left.
+//
+// sample profiles file content:
+//
+// ; section: weapon decl, relative to weapon/zion/player/sp/ unless it's a
+// ; full path; L2 / R2: profile or mode, its name, then its extras
+// [pistol]
+// L2 = profile Bow 0 4 8 8
+// R2 = mode Rigid_A 60 71 56 128 195 210 255
+//
+namespace TriggerProfiles {
+
+    struct Trigger {
+        bool isCustomTrigger = false;   // value is a TriggerMode, not a
+                                        // TriggerProfile
+        int value = 0;
+        std::vector<uint8_t> extras;
+    };
+
+    struct Triggers {
+        Trigger L2;
+        Trigger R2;
+    };
+
+    // looks weapon ids up without copying them into a std::string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>()(name);
+        }
+    };
+
+    // weapon decl -> triggers
+    using Table = std::unordered_map<std::string, Triggers, NameHash,
+            std::equal_to<>>;
+
+    // Maps a profile (or, if custom, mode) name to its enum value; the enums
+    // live in the DualSensitive client, which only builds on Windows
+    using Resolver = bool (*)(const std::string& name, bool custom,
+            int& value);
+
+    // Parses a whole profiles file into out; on failure, error holds the
+    // first problem found and its line
+    bool Parse(const std::string& text, Resolver resolve, Table& out,
+            std::string& error);
+
+    // Publishes defaults, then loads path (if it exists) and keeps polling
+    // it every pollInterval. onReload runs on the scheduler thread after a
+    // reloaded table has been published.
+    void Start(const char *path, Table defaults, Resolver resolve,
+            void (*onReload)(), std::chrono::milliseconds pollInterval);
+
+    namespace detail {
+        extern std::atomic<const Table *> g_table;
+        extern std::atomic<uint32_t> g_epoch;
+        extern std::atomic<uint32_t> g_readers[2];
+    }
+
+    // Pins the current table for as long as it lives; keep it short, a
+    // replaced table can't be freed while a reader is inside it
+    class Reader {
+    public:
+        Reader() {
+            for (;;) {
+                m_epoch = detail::g_epoch.load();
+                detail::g_readers[m_epoch & 1].fetch_add(1);
+                // the grace period may have ended between the two; retry in
+                // the new one rather than be missed by the writer
+                if (detail::g_epoch.load() == m_epoch)
+                    break;
+                detail::g_readers[m_epoch & 1].fetch_sub(1);
+            }
+            m_table = detail::g_table.load();
+        }
+
+        ~Reader() {
+            detail::g_readers[m_epoch & 1].fetch_sub(1,
+                    std::memory_order_release);
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // nullptr if the weapon has no settings
+        const Triggers *Find(std::string_view weaponId) const {
+            if (!m_table)
+                return nullptr;
+            auto it = m_table->find(weaponId);
+            return it == m_table->end() ? nullptr : &it->second;
+        }
+
+    private:
+        uint32_t m_epoch;
+        const Table *m_table;
+    };
+
+    struct Stats {
+        uint64_t reloads = 0;       // tables published from the file
+        uint64_t rejected = 0;      // file versions that failed to parse
+        uint64_t freed = 0;         // replaced tables reclaimed
+    };
+    Stats GetStats();
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define TSC_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TSC_HAS_RDTSC 1
+#endif
+
+// Cheap timestamps for the hot paths (hooks). The cycle counter is invariant
+// on every CPU the game supports, so converting ticks to time only needs a
+// one-off calibration against the steady clock.
+namespace Tsc {
+    inline uint64_t Now() {
+#ifdef TSC_HAS_RDTSC
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Blocks for ~20 ms the first time it's called; don't call it from a hook
+    inline double TicksPerUs() {
+        static const double ticksPerUs = [] {
+#ifdef TSC_HAS_RDTSC
+            using Clock = std::chrono::steady_clock;
+            const auto t0 = Clock::now();
+            const uint64_t c0 = Now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const uint64_t c1 = Now();
+            const auto t1 = Clock::now();
+            const double us =
+                std::chrono::duration<double, std::micro>(t1 - t0).count();
+            return us > 0 ? (c1 - c0) / us : 1.0;
+#else
+            return 1000.0;
+#endif
+        }();
+        return ticksPerUs;
+    }
+}
@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include "Memory.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -8,14 +9,9 @@
 
 // reg2k
 namespace Utils {
+    // a plain copy from readable memory; see Memory.h
     bool ReadMemory(uintptr_t addr, void* data, size_t len) {
-        DWORD oldProtect;
-        if (VirtualProtect((void*)addr, len, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-            memcpy(data, (void*)addr, len);
-            if (VirtualProtect((void*)addr, len, oldProtect, &oldProtect))
-                return true;
-        }
-        return false;
+        return Memory::Read(addr, data, len);
     }
 
     void WriteMemory(uintptr_t addr, void* data, size_t len) {
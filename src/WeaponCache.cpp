@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#include "WeaponCache.h"
+#include "Logger.h"
+
+#include <atomic>
+#include <cstddef>
+
+namespace {
+    // the game has 17 weapons (mods included); collisions just cost a lookup
+    constexpr size_t kSlots = 32;
+
+    struct Slot {
+        uint32_t generation = 0;    // 0: never stored
+        const void *player = nullptr;
+        long long decl = 0;
+        WeaponCache::Entry entry;
+    };
+
+    Slot g_slots[kSlots];
+    // starts at 1 so that empty slots never match
+    uint32_t g_generation = 1;
+    // one writer (the game thread); read by the stats dump
+    std::atomic<uint64_t> g_hits{0};
+    std::atomic<uint64_t> g_misses{0};
+    std::atomic<uint64_t> g_invalidations{0};
+}
+
+static void Bump(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+}
+
+static Slot& SlotFor(const void *player, long long decl) {
+    // decls and players are heap pointers: mix them down
+    uint64_t h = (uint64_t)decl ^ (uint64_t)(uintptr_t)player;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return g_slots[h & (kSlots - 1)];
+}
+
+namespace WeaponCache {
+
+    bool FindByDecl(const void *player, long long decl, Entry& entry) {
+        const Slot& slot = SlotFor(player, decl);
+        if (slot.generation != g_generation || slot.player != player ||
+                slot.decl != decl) {
+            Bump(g_misses);
+            return false;
+        }
+        Bump(g_hits);
+        entry = slot.entry;
+        return true;
+    }
+
+    void StoreByDecl(const void *player, long long decl, const Entry& entry) {
+        if (!entry.weapon)
+            return;
+        Slot& slot = SlotFor(player, decl);
+        slot.generation = g_generation;
+        slot.player = player;
+        slot.decl = decl;
+        slot.entry = entry;
+    }
+
+    void Invalidate() {
+        if (++g_generation == 0) {
+            // wrapped: old tags could match again
+            for (size_t i = 0; i < kSlots; i++)
+                g_slots[i] = Slot();
+            g_generation = 1;
+        }
+        Bump(g_invalidations);
+        _LOGD(LOG_HOOKS, "* weapon cache invalidated (hits: %llu, misses: %llu)",
+                (unsigned long long)g_hits.load(std::memory_order_relaxed),
+                (unsigned long long)g_misses.load(std::memory_order_relaxed));
+    }
+
+    Stats GetStats() {
+        Stats stats;
+        stats.hits = g_hits.load(std::memory_order_relaxed);
+        stats.misses = g_misses.load(std::memory_order_relaxed);
+        stats.invalidations = g_invalidations.load(std::memory_order_relaxed);
+        return stats;
+    }
+}
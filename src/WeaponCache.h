@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Weapons the hooks have already resolved.
+//
+// Selecting a weapon by decl costs the hook a virtual call for the weapon
+// manager and an engine lookup, right before the game's own function does
+// the same. The answer only changes when the player's inventory is rebuilt
+// (level load, death), so it's kept in a small direct-mapped table keyed by
+// (player, decl). Each entry is tagged with the generation it was stored
+// in; Invalidate() bumps the generation, which retires every entry at once.
+//
+// Game thread only, like the hooks that use it; GetStats() may be called
+// from any thread.
+namespace WeaponCache {
+    struct Entry {
+        void *weapon = nullptr;
+        // the decl's name, as the Pipeline takes it; owned by the game
+        const char *name = nullptr;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t invalidations = 0;
+    };
+
+    bool FindByDecl(const void *player, long long decl, Entry& entry);
+    // null weapons aren't kept: the player may pick the weapon up later
+    void StoreByDecl(const void *player, long long decl, const Entry& entry);
+
+    // level load, death: the weapons may be gone or replaced
+    void Invalidate();
+
+    Stats GetStats();
+}
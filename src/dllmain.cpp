@@ -1,4 +1,9 @@
 #include "DualsenseMod.h"
+#include "Logger.h"
+#include "HookStats.h"
+#include "Recorder.h"
+#include "Scheduler.h"
+#include "Timeline.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -10,6 +15,15 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
             break;
 
         case DLL_PROCESS_DETACH:
+            // lpReserved is non-NULL when the whole process is terminating,
+            // in which case the scheduler thread is already gone
+            if (!lpReserved)
+                Scheduler::Stop();
+            HookStats::Dump();
+            Timeline::Export(TIMELINE_LOCATION);
+            Logger::Close(lpReserved != nullptr);
+            Trace::Close();
+            Recorder::Close();
             break;
     }
     return TRUE;
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "sscan/Pattern.h"
+#include "../Memory.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -324,13 +325,9 @@ private:
 //--------------------
 
 namespace RVAUtils {
+    // no protection changes: the rel32s read here are in the game's image,
+    // which is readable as is
     inline bool ReadMemory(uintptr_t addr, void* data, size_t len) {
-        DWORD oldProtect;
-        if (VirtualProtect((void *)addr, len, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-            memcpy(data, (void*)addr, len);
-            if (VirtualProtect((void *)addr, len, oldProtect, &oldProtect))
-                return true;
-        }
-        return false;
+        return Memory::Read(addr, data, len);
     }
 }
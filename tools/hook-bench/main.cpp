@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// Hook microbenchmarks
+//
+// Runs the mod's detours (src/GameHooks.cpp) in a loop against fabricated
+// game objects laid out the way the hooks expect them (weapon name at
+// weapon[6]+8, ammo count at +0x38, the idPlayer vtable
+// slots at 0x660/0x678/0x6C8/0xB20) with stubbed-out originals, and reports
+// the time and heap allocations per call, hook timers included. Trigger
+// sends go to a mock sink, so the cost of the DualSensitive client itself
+// isn't part of the numbers.
+//
+// usage: hook-bench [--iterations N]
+
+#include "GameHooks.h"
+#include "GameState.h"
+#include "Logger.h"
+#include "Pipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+Config g_config;
+Logger g_logger;
+
+// Heap allocations made by the calling thread
+static thread_local uint64_t g_allocations = 0;
+
+void *operator new(size_t size) {
+    g_allocations++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    g_allocations++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// Fabricated game objects
+
+struct FakeDecl {
+    void *unused;
+    const char *name;       // weapon[6] + 8
+};
+
+struct alignas(16) FakeWeapon {
+    long long fields[8];    // fields[6]: FakeDecl *
+    uint8_t rest[0x900];
+
+    explicit FakeWeapon(FakeDecl *decl) {
+        memset(this, 0, sizeof(*this));
+        fields[6] = (long long)(uintptr_t)decl;
+    }
+};
+
+struct alignas(16) FakeAmmo {
+    uint8_t bytes[0x80];    // count at +0x38
+
+    explicit FakeAmmo(int count) {
+        memset(bytes, 0, sizeof(bytes));
+        SetCount(count);
+    }
+    void SetCount(int count) {
+        memcpy(bytes + Hooks::kAmmoCountOffset, &count, sizeof(count));
+    }
+};
+
+struct alignas(16) FakePlayer {
+    void **vtable;
+    uint8_t bytes[Hooks::kCurrWeaponHandleOffset + 0x100];
+};
+
+static FakeDecl g_shotgunDecl = { nullptr, "weapon/zion/player/sp/shotgun" };
+static FakeDecl g_pistolDecl = { nullptr, "weapon/zion/player/sp/pistol" };
+static FakeWeapon g_shotgun(&g_shotgunDecl);
+static FakeWeapon g_pistol(&g_pistolDecl);
+static FakeAmmo g_shells(20);
+static FakePlayer g_player;
+static void *g_playerVtable[Hooks::kPlayerStateSlot / 8 + 1];
+static long long g_weaponMgr[4];
+static bool g_playerDead = false;
+
+// idPlayer virtuals
+static void *__fastcall FakeGetWeaponMgr(Player *) { return g_weaponMgr; }
+static uint64_t g_handle = 1;
+static uint64_t __fastcall FakeGetHandle(Player *, uint32_t) { return g_handle; }
+static bool __fastcall FakeIsDead(void *) { return g_playerDead; }
+static uint32_t __fastcall FakePlayerState(Player *) { return 0; }
+
+// game functions
+static Weapon *__fastcall FakeHandleToPointer(uint64_t) { return &g_shotgun; }
+static void *__fastcall FakeGetWeaponFromDecl(long long *, long long decl) {
+    return decl ? &g_shotgun : &g_pistol;
+}
+
+// originals
+static void __fastcall OnWeaponSelected_Stub(void *, long long *) {}
+static unsigned long long __fastcall SelectWeaponByDeclExplicit_Stub(
+        long long *, long long, char, char) { return 0; }
+static void __fastcall LevelLoadCompleted_Stub(long long *) {}
+static void __fastcall Damage_Stub(void *, void *, void *, long long, float,
+        const float *, const float *) {}
+static void __fastcall UpdateWeapon_Stub(void *) {}
+static int __fastcall UpdateAmmo_Stub(void *ammo, int delta, char) {
+    int count;
+    memcpy(&count, (uint8_t *)ammo + Hooks::kAmmoCountOffset, sizeof(count));
+    count += delta;
+    memcpy((uint8_t *)ammo + Hooks::kAmmoCountOffset, &count, sizeof(count));
+    return count;
+}
+static bool __fastcall SetFireMode_Stub(void *, uint32_t, char) {
+    return true;
+}
+static void __fastcall idHandsUpdate_Stub(void *, void *) {}
+
+class CountingSink : public TriggerSink
+{
+public:
+    uint64_t commands = 0;
+
+    void SendWeapon(const char *) override { commands++; }
+    void Reset() override { commands++; }
+    void NoAmmo() override { commands++; }
+};
+
+static CountingSink g_sink;
+
+// the current weapon's handle, in the player and as FakeGetHandle reports it
+static void SetHandle(uint64_t handle) {
+    g_handle = handle;
+    memcpy(g_player.bytes + Hooks::kCurrWeaponHandleOffset - sizeof(void *),
+            &handle, sizeof(handle));
+}
+
+static void SetUpGame() {
+    g_playerVtable[Hooks::kGetWeaponMgrSlot / 8] = (void *)FakeGetWeaponMgr;
+    g_playerVtable[Hooks::kGetHandleSlot / 8] = (void *)FakeGetHandle;
+    g_playerVtable[Hooks::kIsDeadSlot / 8] = (void *)FakeIsDead;
+    g_playerVtable[Hooks::kPlayerStateSlot / 8] = (void *)FakePlayerState;
+    g_player.vtable = g_playerVtable;
+    SetHandle(1);
+
+    Hooks::HandleToPointer = FakeHandleToPointer;
+    Hooks::GetWeaponFromDecl = FakeGetWeaponFromDecl;
+    Hooks::OnWeaponSelected_Original = OnWeaponSelected_Stub;
+    Hooks::SelectWeaponByDeclExplicit_Original = SelectWeaponByDeclExplicit_Stub;
+    Hooks::LevelLoadCompleted_Original = LevelLoadCompleted_Stub;
+    Hooks::Damage_Original = Damage_Stub;
+    Hooks::UpdateWeapon_Original = UpdateWeapon_Stub;
+    Hooks::UpdateAmmo_Original = UpdateAmmo_Stub;
+    Hooks::SetFireMode_Original = SetFireMode_Stub;
+    Hooks::idHandsUpdate_Original = idHandsUpdate_Stub;
+
+    Pipeline::SetSink(&g_sink);
+}
+
+// Brings the pipeline to the in-game steady state: player known, shotgun
+// selected with its ammo bound, hands ticking
+static void EnterGame() {
+    FSM::Set(GameState::Idle);
+    Pipeline::Reset();
+    Hooks::SelectWeaponByDeclExplicit_Hook((long long *)&g_player, 1, 0, 0);
+    Hooks::UpdateWeapon_Hook(&g_player);
+    Hooks::LevelLoadCompleted_Hook(nullptr);
+    Hooks::OnWeaponSelected_Hook(&g_player, g_shotgun.fields);
+    Hooks::UpdateAmmo_Hook(&g_shells, 0, 0);
+    Hooks::idHandsUpdate_Hook(nullptr, nullptr);
+}
+
+template <typename F>
+static void Bench(const char *name, uint64_t iterations, F&& call) {
+    EnterGame();
+    for (uint64_t i = 0; i < iterations / 100 + 1; i++)
+        call(i);
+
+    const uint64_t commandsBefore = g_sink.commands;
+    const uint64_t allocationsBefore = g_allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++)
+        call(i);
+    const double ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+
+    printf("%-40s %10.1f %12.2f %12.2f\n", name, ns / iterations,
+            (double)(g_allocations - allocationsBefore) / iterations,
+            (double)(g_sink.commands - commandsBefore) / iterations);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    uint64_t iterations = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!iterations)
+        iterations = 1;
+
+    SetUpGame();
+
+    printf("%-40s %10s %12s %12s\n", "hook", "ns/call", "allocs/call",
+            "sends/call");
+
+    // the weapon handle offset is checked until the handle changes: a
+    // player who never switches weapons keeps it checking
+    Bench("UpdateWeapon (same weapon, checking)", iterations, [](uint64_t) {
+        Hooks::UpdateWeapon_Hook(&g_player);
+    });
+
+    Bench("UpdateWeapon (switching, verified)", iterations, [](uint64_t i) {
+        SetHandle((i & 1) + 1);
+        Hooks::UpdateWeapon_Hook(&g_player);
+    });
+
+    Bench("idHandsUpdate (in game)", iterations, [](uint64_t) {
+        Hooks::idHandsUpdate_Hook(nullptr, nullptr);
+    });
+
+    Bench("UpdateAmmo (firing, ammo left)", iterations, [](uint64_t i) {
+        // stays well above zero: -1, +1, -1, ...
+        Hooks::UpdateAmmo_Hook(&g_shells, (i & 1) ? 1 : -1, 0);
+    });
+
+    Bench("UpdateAmmo (running dry / refilled)", iterations, [](uint64_t i) {
+        g_shells.SetCount((i & 1) ? 1 : 0);
+        Hooks::UpdateAmmo_Hook(&g_shells, 0, 0);
+    });
+
+    Bench("SetFireMode (same mode)", iterations, [](uint64_t) {
+        Hooks::SetFireMode_Hook(&g_shotgun, 0, 0);
+    });
+
+    Bench("SetFireMode (mod toggles: SendTriggers)", iterations,
+            [](uint64_t i) {
+        Hooks::SetFireMode_Hook(&g_shotgun, (uint32_t)(i & 1), 0);
+    });
+
+    Bench("OnWeaponSelected (swap: SendTriggers)", iterations,
+            [](uint64_t i) {
+        Hooks::OnWeaponSelected_Hook(&g_player,
+                (i & 1) ? g_pistol.fields : g_shotgun.fields);
+    });
+
+    Bench("SelectWeaponByDeclExplicit (cached)", iterations, [](uint64_t) {
+        Hooks::SelectWeaponByDeclExplicit_Hook((long long *)&g_player, 1, 0,
+                0);
+    });
+
+    Bench("Damage (player survives)", iterations, [](uint64_t) {
+        Hooks::Damage_Hook(&g_player, nullptr, nullptr, 0, 1.0f, nullptr,
+                nullptr);
+    });
+
+    return 0;
+}
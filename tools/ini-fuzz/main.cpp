@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// IniFile fuzz driver
+//
+// Parses arbitrary bytes with IniFile, looks every indexed key up again
+// through the typed getters, and checks that what it indexed is consistent
+// with the input. Built as a libFuzzer target with -DINI_FUZZ_LIBFUZZER=ON
+// (clang); otherwise as a standalone driver that runs the files given on
+// the command line, or mutates a built-in seed corpus for a number of
+// iterations.
+//
+// usage: ini-fuzz [--iterations N] [--seed N] [FILE...]
+
+#include "IniFile.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define FUZZ_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "ini-fuzz: %s:%d: %s\n", __FILE__, __LINE__, \
+                    #cond); \
+            abort(); \
+        } \
+    } while (0)
+
+static void FuzzOne(const uint8_t *data, size_t size) {
+    const std::string text((const char *)data, size);
+    int lines = 1;
+    for (char c : text)
+        lines += c == '\n';
+
+    IniFile ini;
+    ini.Parse(text);
+
+    for (const IniFile::Section& s : ini.Sections()) {
+        FUZZ_CHECK(s.line >= 1 && s.line <= lines);
+        FUZZ_CHECK(s.name.find('\n') == std::string_view::npos);
+        for (const IniFile::Entry& e : s.entries) {
+            FUZZ_CHECK(e.line > s.line && e.line <= lines);
+            FUZZ_CHECK(e.key.find('\n') == std::string_view::npos);
+            FUZZ_CHECK(e.value.find('\n') == std::string_view::npos);
+            FUZZ_CHECK(e.key.find('=') == std::string_view::npos);
+
+            // the first of duplicate keys wins, and any section with the
+            // same name may hold it
+            const IniFile::Entry *found = ini.Find(s.name, e.key);
+            FUZZ_CHECK(found && IniFile::IEquals(found->key, e.key));
+            FUZZ_CHECK(found->line <= e.line);
+
+            std::string_view value;
+            FUZZ_CHECK(ini.Get(s.name, e.key, value));
+            FUZZ_CHECK(value.data() == found->value.data());
+            bool b;
+            uint64_t n64;
+            uint32_t n32;
+            ini.Get(s.name, e.key, b);
+            ini.Get(s.name, e.key, n64);
+            ini.Get(s.name, e.key, n32);
+        }
+    }
+    for (const IniFile::Error& e : ini.Errors()) {
+        FUZZ_CHECK(e.line >= 0 && e.line <= lines);
+        FUZZ_CHECK(!e.message.empty());
+    }
+}
+
+#ifdef INI_FUZZ_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FuzzOne(data, size);
+    return 0;
+}
+
+#else
+
+static const char *const kSeeds[] = {
+    "[app]\ndebug=true\nlog_categories=hooks, fsm\npause_threshold_ms=350\n",
+    "\xEF\xBB\xBF; comment\r\n[App]\r\nKey = \"quoted\"\r\n\r\nkey=dup\r\n",
+    "[pistol]\nL2 = profile Galloping 3 9 1 2 30\nR2 = mode Rigid\n",
+    "[unterminated\nk=v\n[]\n=\n[ s ]\nno equals\nwide=0x1ffffffff\n",
+};
+
+static bool ReadFile(const char *path, std::string& out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// byte flips, inserted INI punctuation, and splices of other seeds
+static void Mutate(std::string& s, std::mt19937_64& rng) {
+    static const char kPunct[] = "[]=;#\"'\r\n \t0x";
+    const int edits = 1 + (int)(rng() % 8);
+    for (int i = 0; i < edits; i++) {
+        const size_t pos = s.empty() ? 0 : rng() % (s.size() + 1);
+        switch (rng() % 5) {
+            case 0:
+                if (pos < s.size())
+                    s[pos] = (char)rng();
+                break;
+            case 1:
+                s.insert(pos, 1, kPunct[rng() % (sizeof(kPunct) - 1)]);
+                break;
+            case 2:
+                if (pos < s.size())
+                    s.erase(pos, 1 + rng() % 16);
+                break;
+            case 3: {
+                const char *seed = kSeeds[rng() % std::size(kSeeds)];
+                const size_t len = strlen(seed);
+                const size_t from = rng() % len;
+                s.insert(pos, seed + from, rng() % (len - from + 1));
+                break;
+            }
+            default:
+                s.insert(pos, rng() % 512, (char)('a' + rng() % 26));
+                break;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t iterations = 100000;
+    uint64_t seed = 1;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        } else
+            files.push_back(argv[i]);
+    }
+
+    if (!files.empty()) {
+        for (const char *path : files) {
+            std::string text;
+            if (!ReadFile(path, text))
+                return 1;
+            FuzzOne((const uint8_t *)text.data(), text.size());
+        }
+        printf("%zu file(s) ok\n", files.size());
+        return 0;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::string input;
+    for (uint64_t i = 0; i < iterations; i++) {
+        // start over from a seed now and then, so inputs don't only grow
+        if (i % 64 == 0 || input.size() > 64 * 1024)
+            input = kSeeds[rng() % std::size(kSeeds)];
+        Mutate(input, rng);
+        FuzzOne((const uint8_t *)input.data(), input.size());
+    }
+    printf("%llu input(s) ok (seed %llu)\n", (unsigned long long)iterations,
+            (unsigned long long)seed);
+    return 0;
+}
+
+#endif
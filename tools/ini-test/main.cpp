@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// IniFile and Config checks
+//
+// Feeds IniFile the inputs a hand-edited dualsense-mod.ini or
+// dualsense-mod-triggers.ini can end up with (comments, blank lines, CRLF
+// line endings, lines without '=', duplicate keys, over-long values,
+// unterminated section headers) and checks what it indexes and reports,
+// then loads a Config from a file the same way the mod does. Exits non-zero
+// if anything is off.
+//
+// usage: ini-test
+
+#include "Config.h"
+#include "IniFile.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+Config g_config;
+Logger g_logger;
+
+static int g_checks = 0;
+static int g_failures = 0;
+
+#define CHECK(cond) Check((cond), #cond, __LINE__)
+
+static void Check(bool ok, const char *what, int line) {
+    g_checks++;
+    if (ok)
+        return;
+    g_failures++;
+    printf("  FAIL (line %d): %s\n", line, what);
+}
+
+static std::string_view Value(const IniFile& ini, std::string_view section,
+        std::string_view key) {
+    std::string_view value = "<missing>";
+    ini.Get(section, key, value);
+    return value;
+}
+
+static bool HasError(const IniFile& ini, int line, std::string_view text) {
+    for (const IniFile::Error& e : ini.Errors()) {
+        if (e.line == line && e.message.find(text) != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+static void Comments() {
+    IniFile ini;
+    ini.Parse("; leading comment\n"
+              "# hash comment\n"
+              "\n"
+              "[app]\n"
+              "   ; indented comment\n"
+              "\t\n"
+              "debug = true\n"
+              "value = a ; not a comment\n"
+              "# key = hidden\n");
+    CHECK(ini.Errors().empty());
+    CHECK(ini.Sections().size() == 1);
+    CHECK(ini.Sections()[0].entries.size() == 2);
+    CHECK(ini.Sections()[0].line == 4);
+    // only whole lines are comments
+    CHECK(Value(ini, "app", "value") == "a ; not a comment");
+    CHECK(!ini.Find("app", "key"));
+    bool debug = false;
+    CHECK(ini.Get("app", "debug", debug) && debug);
+}
+
+static void LineEndings() {
+    IniFile ini;
+    ini.Parse("\xEF\xBB\xBF[App]\r\n"
+              "Key = value \r\n"
+              "quoted = \" spaced \"\r\n"
+              "\r\n"
+              "last=no newline");
+    CHECK(ini.Errors().empty());
+    CHECK(Value(ini, "app", "key") == "value");
+    CHECK(Value(ini, "APP", "KEY") == "value");
+    CHECK(Value(ini, "app", "quoted") == " spaced ");
+    CHECK(Value(ini, "app", "last") == "no newline");
+    CHECK(ini.Find("app", "last")->line == 5);
+}
+
+static void MissingEquals() {
+    IniFile ini;
+    ini.Parse("[app]\n"
+              "debug\n"
+              "trace = false\n"
+              "= no key\n");
+    CHECK(HasError(ini, 2, "expected 'key = value'"));
+    CHECK(ini.Errors().size() == 1);
+    CHECK(Value(ini, "app", "trace") == "false");
+    CHECK(!ini.Find("app", "debug"));
+    // an empty key is still a key
+    CHECK(Value(ini, "app", "") == "no key");
+}
+
+static void DuplicateKeys() {
+    IniFile ini;
+    ini.Parse("[app]\n"
+              "pause_threshold_ms = 200\n"
+              "PAUSE_THRESHOLD_MS = 300\n"
+              "[app]\n"
+              "pause_threshold_ms = 400\n");
+    // the first wins, like GetPrivateProfileString; later ones are reported
+    uint64_t threshold = 0;
+    CHECK(ini.Get("app", "pause_threshold_ms", threshold) && threshold == 200);
+    CHECK(HasError(ini, 3, "already set on line 2"));
+    // a repeated section is listed again, and its keys don't clash
+    CHECK(ini.Sections().size() == 2);
+    CHECK(ini.Errors().size() == 1);
+}
+
+static void LongValues() {
+    const std::string huge(64 * 1024, 'x');
+    const std::string digits(40, '9');
+    IniFile ini;
+    ini.Parse("[app]\n"
+              "huge = " + huge + "\n"
+              "digits = " + digits + "\n"
+              "wide = 0x1ffffffff\n"
+              "[" + std::string(1000, 's') + "]\n"
+              "k = v\n");
+    CHECK(ini.Errors().empty());
+    // no line or value length limit: nothing is truncated
+    CHECK(Value(ini, "app", "huge") == huge);
+    CHECK(Value(ini, std::string(1000, 's'), "k") == "v");
+
+    uint64_t n = 7;
+    CHECK(!ini.Get("app", "digits", n) && n == 7);
+    CHECK(HasError(ini, 3, "not a non-negative number"));
+    uint64_t wide = 0;
+    CHECK(ini.Get("app", "wide", wide) && wide == 0x1ffffffffull);
+    uint32_t narrow = 5;
+    CHECK(!ini.Get("app", "wide", narrow) && narrow == 5);
+    CHECK(HasError(ini, 4, "not a 32-bit number"));
+}
+
+static void UnterminatedSections() {
+    IniFile ini;
+    ini.Parse("[app\n"
+              "debug = true\n"
+              "[]\n"
+              "empty = 1\n"
+              "[ok]\n"
+              "k = v\n"
+              "[\n");
+    CHECK(HasError(ini, 1, "unterminated section header"));
+    // its keys don't land in whichever section came before it
+    CHECK(HasError(ini, 2, "outside of a section"));
+    CHECK(!ini.Find("app", "debug"));
+    CHECK(Value(ini, "", "empty") == "1");
+    CHECK(Value(ini, "ok", "k") == "v");
+    CHECK(HasError(ini, 7, "unterminated section header"));
+    CHECK(ini.Errors().size() == 3);
+}
+
+static void ConfigFile() {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "ini-test-config.ini";
+    FILE *f = fopen(path.string().c_str(), "wb");
+    if (!f) {
+        perror(path.string().c_str());
+        CHECK(f != nullptr);
+        return;
+    }
+    fputs("; dualsense-mod.ini\r\n"
+          "[app]\r\n"
+          "debug = yes\r\n"
+          "log_categories = Hooks, fsm,,bogus\tAMMO\r\n"
+          "log_level = trace\r\n"
+          "pause_threshold_ms = 50\r\n"
+          "stats_interval_s = 0x3c\r\n"
+          "trigger_rate_hz = 120\r\n"
+          "trigger_rate_hz = 30\r\n", f);
+    fclose(f);
+
+    Config config(path.string().c_str());
+    std::filesystem::remove(path);
+    CHECK(config.isDebugMode);
+    CHECK(!config.isTraceMode);
+    const uint32_t categories = LOG_HOOKS | LOG_FSM | LOG_AMMO;
+    CHECK(config.logMask ==
+            (LOG_DEBUG_BIT(categories) | LOG_TRACE_BIT(categories)));
+    // out of range: the default stays
+    CHECK(config.pauseThresholdMs == 350);
+    CHECK(config.statsIntervalSec == 60);
+    CHECK(config.triggerRateHz == 120);
+
+    Config missing("ini-test-does-not-exist.ini");
+    CHECK(!missing.isDebugMode && missing.triggerRateHz == 60);
+}
+
+int main() {
+    static const struct {
+        const char *name;
+        void (*run)();
+    } tests[] = {
+        { "comments and blank lines", Comments },
+        { "line endings",             LineEndings },
+        { "missing '='",              MissingEquals },
+        { "duplicate keys",           DuplicateKeys },
+        { "long values",              LongValues },
+        { "unterminated sections",    UnterminatedSections },
+        { "config file",              ConfigFile },
+    };
+    for (auto& t : tests) {
+        const int failures = g_failures;
+        t.run();
+        printf("%-28s %s\n", t.name, g_failures == failures ? "ok" : "FAIL");
+    }
+    printf("\n%d check(s), %d failure(s)\n", g_checks, g_failures);
+    return g_failures ? 1 : 0;
+}
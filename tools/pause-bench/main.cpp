@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// Pause detection benchmark
+//
+// Drives the GameState machine the same way the mod does (idHandsUpdate_Hook
+// heartbeat -> pause watcher -> resetAdaptiveTriggers) with synthetic frame
+// streams at several frame rates, mixing in menu-like stalls (which must be
+// detected) and frame hitches below the threshold (which must not). Reports
+// detection latency percentiles, false pauses and the watcher's wake-ups and
+// CPU time, so that changes to the watcher can be compared objectively.
+//
+// usage: pause-bench [--seconds N] [--threshold MS] [--stall MS]
+
+#include "GameState.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+Config g_config;
+Logger g_logger;
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<bool> g_inStall{false};
+static std::atomic<bool> g_stallDetected{false};
+static std::atomic<Clock::rep> g_lastTick{0};
+
+static std::mutex g_resultsMutex;
+static std::vector<double> g_latencies;
+static uint64_t g_falsePauses = 0;
+
+// stands in for resetAdaptiveTriggers
+static void OnPause() {
+    const auto now = Clock::now();
+    const Clock::time_point last{Clock::duration(g_lastTick.load())};
+    std::lock_guard<std::mutex> lock(g_resultsMutex);
+    if (g_inStall.load()) {
+        g_stallDetected.store(true);
+        g_latencies.push_back(
+            std::chrono::duration<double, std::milli>(now - last).count()
+        );
+    } else {
+        g_falsePauses++;
+    }
+}
+
+static double ProcessCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double ThreadCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double Percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t idx = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+struct RunResult {
+    uint64_t frames = 0;
+    uint64_t stalls = 0;
+    uint64_t missed = 0;
+    uint64_t hitches = 0;
+    double   simCpuMs = 0;
+};
+
+// The game thread: ticks at `hz`, with ~2 hitches per second and a stall
+// every `seconds / (stalls + 1)`
+static RunResult SimulateGame(int hz, double seconds, uint64_t thresholdMs,
+        uint64_t stallMs) {
+    RunResult r;
+    std::mt19937 rng(hz);
+    const auto frame = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / hz));
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_real_distribution<double> hitchMs(
+            2000.0 / hz, thresholdMs * 0.9);
+    const double hitchChance = 2.0 / hz;
+
+    const int stallCount = std::max(1, (int)(seconds / 2));
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    const auto stallEvery = (end - start) / (stallCount + 1);
+    auto nextStall = start + stallEvery;
+    auto next = start;
+    const double cpuStart = ThreadCpuMs();
+
+    FSM::Set(GameState::InGame);
+    for (;;) {
+        std::this_thread::sleep_until(next);
+        if (g_inStall.load()) {
+            if (!g_stallDetected.load())
+                r.missed++;
+            g_inStall.store(false);
+        }
+        if (next >= end)
+            break;
+
+        // idHandsUpdate_Hook
+        g_lastTick.store(Clock::now().time_since_epoch().count());
+        if (FSM::Get() != GameState::Idle)
+            FSM::Heartbeat();
+        r.frames++;
+
+        const auto now = Clock::now();
+        if (now >= nextStall) {
+            // menu opened: hands stop ticking
+            r.stalls++;
+            g_stallDetected.store(false);
+            g_inStall.store(true);
+            next = now + std::chrono::milliseconds(stallMs);
+            nextStall += stallEvery;
+        } else if (chance(rng) < hitchChance) {
+            r.hitches++;
+            next = now + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(hitchMs(rng)));
+        } else {
+            next += std::chrono::duration_cast<Clock::duration>(
+                    frame * jitter(rng));
+            if (next < now) next = now;
+        }
+    }
+    FSM::Set(GameState::Idle);
+    r.simCpuMs = ThreadCpuMs() - cpuStart;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    double seconds = 8;
+    uint64_t thresholdMs = 350;
+    uint64_t stallMs = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--seconds"))
+            seconds = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--threshold"))
+            thresholdMs = strtoull(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--stall"))
+            stallMs = strtoull(argv[i + 1], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--threshold MS] "
+                    "[--stall MS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    g_config.pauseThresholdMs = thresholdMs;
+    FSM::StartPauseWatcher(thresholdMs, OnPause);
+
+    // Idle phase first: the watcher should not wake up at all here
+    FSM::WatcherStats before = FSM::GetWatcherStats();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    FSM::WatcherStats after = FSM::GetWatcherStats();
+    printf("threshold: %llu ms, stall: %llu ms, %.0f s per rate\n",
+            (unsigned long long) thresholdMs,
+            (unsigned long long) stallMs, seconds);
+    printf("idle wake-ups/s: %llu\n\n",
+            (unsigned long long) (after.wakeups - before.wakeups));
+
+    printf("%5s %7s %6s %6s %8s %8s %8s %8s %7s %6s %10s %9s\n",
+            "hz", "frames", "stalls", "missed", "p50 ms", "p90 ms",
+            "p99 ms", "max ms", "hitches", "false", "wakeups/s",
+            "cpu ms/s");
+
+    for (int hz : {30, 60, 144, 240}) {
+        {
+            std::lock_guard<std::mutex> lock(g_resultsMutex);
+            g_latencies.clear();
+            g_falsePauses = 0;
+        }
+        before = FSM::GetWatcherStats();
+        const double cpuStart = ProcessCpuMs();
+        const auto start = Clock::now();
+
+        RunResult r = SimulateGame(hz, seconds, thresholdMs, stallMs);
+
+        const double elapsed = std::chrono::duration<double>(
+                Clock::now() - start).count();
+        // everything but the game thread: that's the watcher
+        const double watcherCpuMs = ProcessCpuMs() - cpuStart - r.simCpuMs;
+        after = FSM::GetWatcherStats();
+
+        std::lock_guard<std::mutex> lock(g_resultsMutex);
+        printf("%5d %7llu %6llu %6llu %8.1f %8.1f %8.1f %8.1f %7llu %6llu "
+                "%10.1f %9.3f\n",
+                hz,
+                (unsigned long long) r.frames,
+                (unsigned long long) r.stalls,
+                (unsigned long long) r.missed,
+                Percentile(g_latencies, 50),
+                Percentile(g_latencies, 90),
+                Percentile(g_latencies, 99),
+                Percentile(g_latencies, 100),
+                (unsigned long long) r.hitches,
+                (unsigned long long) g_falsePauses,
+                (after.wakeups - before.wakeups) / elapsed,
+                std::max(0.0, watcherCpuMs) / elapsed
+        );
+        fflush(stdout);
+    }
+
+    FSM::StopPauseWatcher();
+    return 0;
+}
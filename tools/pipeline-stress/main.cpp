@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// Trigger pipeline stress test
+//
+// Recorded sessions don't cover the pathological cases, so this generates
+// event storms into the pipeline at fixed rates: macro-driven weapon
+// swapping, a chaingun running dry and refilling at max fire rate, deaths
+// racing level loads, and a mix of all three. Events come from a "game"
+// thread that also stalls now and then, so the live pause watcher fires in
+// the middle of the storm, while an "init" thread connects the transport at
+// a random point (commands sent before that are lost, as in the mod) and
+// asks the pipeline to resend.
+//
+// Each run reports the achieved event rate, the commands the pipeline issued,
+// how many of them repeated the previous one, the weapon settings held back
+// outside gameplay, the commands lost before the transport connected, the
+// pause resets dropped because gameplay had already resumed, the latency
+// from the event entering the pipeline to the transport having sent the
+// command, and whether the triggers ended up matching the final game state.
+// With --output-rate, the pipeline's output stage caps the commands reaching
+// the transport, and the run also reports how many were written, merged
+// into a newer one while waiting, and dropped as no-ops.
+//
+// usage: pipeline-stress [--scenario swap|chaingun|death-load|mixed|all]
+//                        [--rates R1,R2,...] [--seconds S] [--threshold MS]
+//                        [--send-cost-us US] [--output-rate HZ] [--seed N]
+
+#include "GameState.h"
+#include "HookStats.h"
+#include "Logger.h"
+#include "Pipeline.h"
+#include "Scheduler.h"
+#include "Tsc.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+Config g_config;
+Logger g_logger;
+
+using Clock = std::chrono::steady_clock;
+
+// when the event that's being handled on this thread entered the pipeline
+static thread_local uint64_t g_eventTsc = 0;
+
+static uint64_t g_sendCostTicks = 0;
+
+enum class Sent : uint8_t { None, Weapon, Reset, NoAmmo };
+
+// Stands in for the DualSensitive client: commands before Connect() are
+// lost, the rest take --send-cost-us each. The pipeline serializes the calls.
+class StressSink : public TriggerSink
+{
+public:
+    Histogram latency;      // ticks, event -> command sent
+    uint64_t sent = 0;
+    uint64_t lost = 0;      // before the transport connected
+
+    // last command the pipeline issued and last one that made it out
+    Sent decided = Sent::None;
+    std::string decidedWeapon;
+    Sent applied = Sent::None;
+    std::string appliedWeapon;
+
+    void Start() {
+        latency.Reset();
+        sent = lost = 0;
+        decided = applied = Sent::None;
+        decidedWeapon.clear();
+        appliedWeapon.clear();
+        m_connected.store(false, std::memory_order_relaxed);
+    }
+
+    void Connect() { m_connected.store(true, std::memory_order_release); }
+
+    void SendWeapon(const char *weaponId) override {
+        Send(Sent::Weapon, weaponId);
+    }
+    void Reset() override { Send(Sent::Reset, ""); }
+    void NoAmmo() override { Send(Sent::NoAmmo, ""); }
+
+private:
+    std::atomic<bool> m_connected{false};
+
+    void Send(Sent command, const char *weaponId) {
+        decided = command;
+        decidedWeapon = weaponId;
+        if (!m_connected.load(std::memory_order_acquire)) {
+            lost++;
+            return;
+        }
+        const uint64_t start = Tsc::Now();
+        while (Tsc::Now() - start < g_sendCostTicks)
+            ;
+        applied = command;
+        appliedWeapon = weaponId;
+        sent++;
+        // commands held back by the output stage go out from the scheduler
+        if (g_eventTsc)
+            latency.Record(Tsc::Now() - g_eventTsc);
+    }
+};
+
+static StressSink g_sink;
+static std::atomic<uint64_t> g_pauses{0};
+
+static void OnPause() {
+    g_pauses.fetch_add(1, std::memory_order_relaxed);
+    g_eventTsc = Tsc::Now();
+    Pipeline::OnPaused();
+    // the watcher shares the scheduler thread with the output stage's
+    // flushes, which aren't this event's doing
+    g_eventTsc = 0;
+}
+
+struct WeaponDef {
+    const char *name;
+    int ammo;               // index into the ammo objects, -1: infinite
+};
+
+static const WeaponDef kWeapons[] = {
+    { "weapon/zion/player/sp/pistol",               -1 },
+    { "weapon/zion/player/sp/shotgun",               1 },
+    { "weapon/zion/player/sp/chaingun",              0 },
+    { "weapon/zion/player/sp/heavy_rifle_heavy_ar",  0 },
+    { "weapon/zion/player/sp/rocket_launcher",       2 },
+    { "weapon/zion/player/sp/gauss_rifle",           3 },
+};
+static constexpr int kWeaponCount = sizeof(kWeapons) / sizeof(kWeapons[0]);
+static constexpr int kChaingun = 2;
+
+enum class Scenario { Swap, ChaingunSpin, DeathLoad, Mixed };
+
+static const char *ScenarioName(Scenario scenario) {
+    switch (scenario) {
+        case Scenario::Swap:         return "swap";
+        case Scenario::ChaingunSpin: return "chaingun";
+        case Scenario::DeathLoad:    return "death-load";
+        case Scenario::Mixed:        return "mixed";
+    }
+    return "?";
+}
+
+// The game side: fabricated player, weapons and ammo, and the hook calls a
+// storm of the given kind produces
+class Game
+{
+public:
+    Game(Scenario scenario, uint64_t seed) : m_scenario(scenario), m_rng(seed | 1) {
+        for (int& count : m_ammoCount)
+            count = 50;
+    }
+
+    void Start() {
+        LevelLoad();
+    }
+
+    void Step() {
+        const uint32_t roll = Next() % 100;
+        switch (m_scenario) {
+            case Scenario::Swap:
+                if (roll < 45) Select(Next() % kWeaponCount);
+                else if (roll < 55) Fire();
+                else Tick();
+                break;
+            case Scenario::ChaingunSpin:
+                if (m_weapon != kChaingun) Select(kChaingun);
+                else if (roll < 70) Fire();
+                else if (roll < 80) ToggleMode();
+                else Tick();
+                break;
+            case Scenario::DeathLoad:
+                if (roll < 15) Damage(Next() % 2 == 0);
+                else if (roll < 35) LevelLoad();
+                else if (roll < 55) Select(Next() % kWeaponCount);
+                else Tick();
+                break;
+            case Scenario::Mixed:
+                if (roll < 15) Select(Next() % kWeaponCount);
+                else if (roll < 40) Fire();
+                else if (roll < 45) ToggleMode();
+                else if (roll < 48) Damage(Next() % 4 == 0);
+                else if (roll < 51) LevelLoad();
+                else Tick();
+                break;
+        }
+    }
+
+    // back in gameplay: alive, level loaded and a weapon in hand
+    void Respawn() {
+        LevelLoad();
+        if (FSM::Get() != GameState::InGame)
+            LevelLoad();
+    }
+
+    void Tick() {
+        Stamp();
+        Pipeline::OnHandsTick();
+    }
+
+    int Weapon() const { return m_weapon; }
+
+private:
+    Scenario m_scenario;
+    uint64_t m_rng;
+    int m_weapon = 0;
+    uint32_t m_mode = 0;
+    int m_ammoCount[4];
+    char m_player[16];
+    char m_weapons[kWeaponCount][16];
+    char m_ammo[4][16];
+
+    uint64_t Next() {
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 7;
+        m_rng ^= m_rng << 17;
+        return m_rng;
+    }
+
+    static void Stamp() { g_eventTsc = Tsc::Now(); }
+
+    void Select(int weapon) {
+        m_weapon = weapon;
+        Stamp();
+        Pipeline::OnWeaponSelected(m_weapons[weapon], kWeapons[weapon].name);
+        // the game refreshes the new weapon's ammo right away
+        if (kWeapons[weapon].ammo >= 0)
+            UpdateAmmo(kWeapons[weapon].ammo, 0);
+    }
+
+    void Fire() {
+        const int ammo = kWeapons[m_weapon].ammo;
+        if (ammo < 0) {
+            Tick();
+            return;
+        }
+        // a pickup refills the gun once it ran dry
+        UpdateAmmo(ammo, m_ammoCount[ammo] > 0 ? -1 : 50);
+    }
+
+    void UpdateAmmo(int ammo, int delta) {
+        m_ammoCount[ammo] += delta;
+        Stamp();
+        Pipeline::OnAmmoUpdate(m_ammo[ammo], m_ammoCount[ammo]);
+    }
+
+    void ToggleMode() {
+        m_mode ^= 1;
+        Stamp();
+        Pipeline::OnFireModeSet(true, m_mode);
+    }
+
+    void Damage(bool dies) {
+        if (!Pipeline::IsCurrentPlayer(m_player))
+            return;
+        Stamp();
+        Pipeline::OnPlayerDamaged(dies);
+    }
+
+    // checkpoint (re)load: what SelectWeaponByDeclExplicit, UpdateWeapon and
+    // LevelLoadCompleted report, in the game's order
+    void LevelLoad() {
+        Stamp();
+        Pipeline::OnSelectWeaponByDecl(m_weapons[m_weapon], kWeapons[m_weapon].name);
+        Pipeline::OnSelectWeaponByDeclDone();
+        Pipeline::OnUpdateWeapon(m_player);
+        m_mode = 0;
+        Pipeline::OnFireModeSet(true, m_mode);
+        if (Pipeline::OnLevelLoaded())
+            Pipeline::OnLevelStartWeapon(m_weapons[m_weapon], kWeapons[m_weapon].name);
+    }
+};
+
+struct RunResult {
+    uint64_t events = 0;
+    double seconds = 0;     // excluding the injected stalls
+    Pipeline::Stats stats;
+    uint64_t pauses = 0;
+    bool endStateOk = false;
+    const char *endStateWhy = "";
+};
+
+// Do the triggers match where the game ended up?
+static bool CheckEndState(const Game& game, const char *&why) {
+    if (g_sink.applied != g_sink.decided ||
+            g_sink.appliedWeapon != g_sink.decidedWeapon) {
+        why = "transport missed the last command";
+        return false;
+    }
+    switch (FSM::Get()) {
+        case GameState::InGame:
+            if (g_sink.applied == Sent::Reset || g_sink.applied == Sent::None) {
+                why = "in game with the triggers off";
+                return false;
+            }
+            if (g_sink.applied == Sent::Weapon &&
+                    g_sink.appliedWeapon.rfind(kWeapons[game.Weapon()].name, 0)) {
+                why = "in game with another weapon's triggers";
+                return false;
+            }
+            return true;
+        case GameState::Paused:
+            if (g_sink.applied != Sent::Reset) {
+                why = "paused with the triggers on";
+                return false;
+            }
+            return true;
+        case GameState::Idle:
+            if (g_sink.applied != Sent::Reset && g_sink.applied != Sent::None) {
+                why = "idle with the triggers on";
+                return false;
+            }
+            return true;
+    }
+    return false;
+}
+
+static RunResult Run(Scenario scenario, double rate, double seconds,
+        uint64_t thresholdMs, uint64_t seed) {
+    RunResult result;
+    FSM::Set(GameState::Idle);
+    Pipeline::Reset();
+    const Pipeline::Stats statsBefore = Pipeline::GetStats();
+    g_sink.Start();
+    g_pauses.store(0, std::memory_order_relaxed);
+    FSM::StartPauseWatcher(thresholdMs, OnPause);
+
+    const auto threshold = std::chrono::milliseconds(thresholdMs);
+    const auto duration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+
+    // the transport comes up somewhere in the first half of the storm
+    std::thread init([&] {
+        std::this_thread::sleep_for(duration * (double)(seed % 50) / 100.0);
+        g_sink.Connect();
+        g_eventTsc = Tsc::Now();
+        Pipeline::Resend();
+    });
+
+    Game game(scenario, seed);
+    std::thread gameThread([&] {
+        uint64_t rng = seed * 2654435761u + 1;
+        const auto start = Clock::now();
+        auto scheduleStart = start;
+        game.Start();
+        uint64_t events = 0;
+        Clock::duration stalled{};
+        for (;;) {
+            const auto now = Clock::now();
+            if (now - start >= duration)
+                break;
+            // keep to the target rate; when behind, this is the saturation
+            const auto due = scheduleStart + std::chrono::duration_cast<
+                    Clock::duration>(std::chrono::duration<double>(events / rate));
+            if (now < due)
+                continue;
+
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            // a menu or a hitch every ~100 ms of the storm
+            if (rng % (uint64_t)(rate / 10 + 1) == 0) {
+                const auto stallStart = Clock::now();
+                std::this_thread::sleep_for(rng % 2 ? threshold * 2 : threshold / 2);
+                stalled += Clock::now() - stallStart;
+                scheduleStart += Clock::now() - stallStart;
+            }
+            game.Step();
+            events++;
+        }
+        result.events = events;
+        result.seconds = std::chrono::duration<double>(
+                Clock::now() - start - stalled).count();
+    });
+
+    gameThread.join();
+    init.join();
+
+    // settle: either keep playing or open the menu and wait for the watcher
+    if (seed % 2) {
+        game.Respawn();
+        const auto end = Clock::now() + threshold * 3;
+        while (Clock::now() < end) {
+            game.Tick();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    } else {
+        std::this_thread::sleep_for(threshold * 3);
+    }
+
+    FSM::StopPauseWatcher();
+    const Pipeline::Stats stats = Pipeline::GetStats();
+    result.stats.commands = stats.commands - statsBefore.commands;
+    result.stats.repeated = stats.repeated - statsBefore.repeated;
+    result.stats.deferred = stats.deferred - statsBefore.deferred;
+    result.stats.stalePauses = stats.stalePauses - statsBefore.stalePauses;
+    result.stats.resends = stats.resends - statsBefore.resends;
+    result.stats.written = stats.written - statsBefore.written;
+    result.stats.merged = stats.merged - statsBefore.merged;
+    result.stats.dropped = stats.dropped - statsBefore.dropped;
+    result.pauses = g_pauses.load(std::memory_order_relaxed);
+    result.endStateOk = CheckEndState(game, result.endStateWhy);
+    return result;
+}
+
+static std::vector<double> ParseRates(const char *list) {
+    std::vector<double> rates;
+    while (*list) {
+        char *end = nullptr;
+        const double rate = strtod(list, &end);
+        if (end == list)
+            break;
+        if (rate > 0)
+            rates.push_back(rate);
+        list = *end == ',' ? end + 1 : end;
+    }
+    return rates;
+}
+
+int main(int argc, char **argv) {
+    std::vector<Scenario> scenarios = {
+        Scenario::Swap, Scenario::ChaingunSpin, Scenario::DeathLoad,
+        Scenario::Mixed
+    };
+    std::vector<double> rates = { 1000, 10000, 100000, 500000 };
+    double seconds = 1.0;
+    uint64_t thresholdMs = 20;
+    double sendCostUs = 2.0;
+    uint32_t outputRate = 0;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--scenario") && hasValue) {
+            const char *name = argv[++i];
+            scenarios.clear();
+            for (Scenario s : { Scenario::Swap, Scenario::ChaingunSpin,
+                    Scenario::DeathLoad, Scenario::Mixed }) {
+                if (!strcmp(name, "all") || !strcmp(name, ScenarioName(s)))
+                    scenarios.push_back(s);
+            }
+            if (scenarios.empty()) {
+                fprintf(stderr, "Unknown scenario: %s\n", name);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--rates") && hasValue) {
+            rates = ParseRates(argv[++i]);
+        } else if (!strcmp(argv[i], "--seconds") && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--threshold") && hasValue) {
+            thresholdMs = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--send-cost-us") && hasValue) {
+            sendCostUs = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--output-rate") && hasValue) {
+            outputRate = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--seed") && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--scenario swap|chaingun|death-load|"
+                    "mixed|all] [--rates R1,R2,...] [--seconds S] "
+                    "[--threshold MS] [--send-cost-us US] "
+                    "[--output-rate HZ] [--seed N]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (rates.empty() || seconds <= 0 || !thresholdMs) {
+        fprintf(stderr, "Invalid rates, duration or threshold\n");
+        return 1;
+    }
+
+    const double ticksPerUs = Tsc::TicksPerUs();
+    g_sendCostTicks = (uint64_t)(sendCostUs * ticksPerUs);
+    Pipeline::SetSink(&g_sink);
+    if (outputRate) {
+        // flushes the commands held back by the output stage
+        Scheduler::Start();
+        Pipeline::SetOutputRate(outputRate, 4);
+    }
+
+    printf("pause threshold: %llu ms, send cost: %.1f us, %.1f s per run, "
+            "output rate: %u/s\n\n",
+            (unsigned long long)thresholdMs, sendCostUs, seconds, outputRate);
+    printf("%-10s %9s %9s %8s %8s %8s %8s %6s %6s %6s %8s %8s %8s %8s %8s "
+            "%8s %8s  %s\n",
+            "scenario", "target/s", "events/s", "cmds", "repeat", "deferred",
+            "lost", "stale", "resend", "pauses", "written", "merged",
+            "dropped", "p50 us", "p99 us", "p99.9 us", "max us", "end state");
+
+    int failures = 0;
+    uint64_t runSeed = seed;
+    for (Scenario scenario : scenarios) {
+        for (double rate : rates) {
+            const RunResult r = Run(scenario, rate, seconds, thresholdMs,
+                    runSeed++);
+            const double achieved = r.events / r.seconds;
+            const Histogram& h = g_sink.latency;
+            printf("%-10s %9.0f %9.0f%c %8llu %8llu %8llu %8llu %6llu %6llu %6llu "
+                    "%8llu %8llu %8llu %8.1f %8.1f %8.1f %8.1f  %s%s\n",
+                    ScenarioName(scenario), rate, achieved,
+                    achieved < rate * 0.95 ? '*' : ' ',
+                    (unsigned long long)r.stats.commands,
+                    (unsigned long long)r.stats.repeated,
+                    (unsigned long long)r.stats.deferred,
+                    (unsigned long long)g_sink.lost,
+                    (unsigned long long)r.stats.stalePauses,
+                    (unsigned long long)r.stats.resends,
+                    (unsigned long long)r.pauses,
+                    (unsigned long long)r.stats.written,
+                    (unsigned long long)r.stats.merged,
+                    (unsigned long long)r.stats.dropped,
+                    h.Percentile(50) / ticksPerUs,
+                    h.Percentile(99) / ticksPerUs,
+                    h.Percentile(99.9) / ticksPerUs,
+                    h.Max() / ticksPerUs,
+                    r.endStateOk ? "ok" : "FAIL: ",
+                    r.endStateOk ? "" : r.endStateWhy);
+            fflush(stdout);
+            if (!r.endStateOk)
+                failures++;
+        }
+    }
+    printf("\n* saturated: the game thread couldn't keep up with the target "
+            "rate\n");
+    if (outputRate)
+        Scheduler::Stop();
+    return failures ? 2 : 0;
+}
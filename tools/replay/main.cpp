@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// Session replay
+//
+// Feeds a dualsensemod.rec file (written when record=true) through the same
+// game state machine and trigger pipeline the mod runs, against a mock
+// controller transport. By default events are replayed back to back, as
+// fast as possible, and the pipeline's cost per event type is reported;
+// pauses come from the recording. With --realtime the original pacing is
+// kept and pauses are detected by the live pause watcher instead.
+//
+// The digest of the resulting trigger commands is stable across runs, so
+// comparing it between builds catches behaviour changes.
+//
+// usage: replay <file.rec> [--iterations N] [--realtime] [--threshold MS]
+//               [--print] [--log FILE]
+
+#include "GameState.h"
+#include "HookStats.h"
+#include "Logger.h"
+#include "Pipeline.h"
+#include "RecordFormat.h"
+#include "Tsc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+Config g_config;
+Logger g_logger;
+
+struct Event {
+    uint8_t  kind;
+    uint8_t  flag;
+    uint32_t value;
+    uint64_t tsc;
+    uint64_t object;
+    const char *name;
+};
+
+struct Recording {
+    RecordFormat::FileHeader header;
+    std::vector<std::string> names;     // id - 1 -> name
+    std::vector<Event> events;
+    uint64_t dropped = 0;
+};
+
+class Reader
+{
+public:
+    explicit Reader(std::vector<char> data) : m_data(std::move(data)) {}
+
+    bool AtEnd() const { return m_pos >= m_data.size(); }
+
+    template <typename T>
+    bool Get(T& out) {
+        if (m_pos + sizeof(T) > m_data.size()) return false;
+        memcpy(&out, m_data.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string& out, uint16_t len) {
+        if (m_pos + len > m_data.size()) return false;
+        out.assign(m_data.data() + m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    size_t Pos() const { return m_pos; }
+
+private:
+    std::vector<char> m_data;
+    size_t m_pos = 0;
+};
+
+static bool Load(const char *path, Recording& rec) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    std::vector<char> data;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    Reader r(std::move(data));
+    if (!r.Get(rec.header) || memcmp(rec.header.magic, RecordFormat::kMagic,
+                sizeof(rec.header.magic))) {
+        fprintf(stderr, "%s: not a recording\n", path);
+        return false;
+    }
+    if (rec.header.version != RecordFormat::kVersion) {
+        fprintf(stderr, "%s: unsupported recording version %u\n",
+                path, rec.header.version);
+        return false;
+    }
+
+    // names are resolved once everything is loaded; the vector may grow
+    std::vector<uint16_t> nameIds;
+    while (!r.AtEnd()) {
+        uint8_t kind = 0;
+        r.Get(kind);
+        bool ok = true;
+
+        if (kind == RecordFormat::StringDef) {
+            uint16_t id, len;
+            std::string s;
+            ok = r.Get(id) && r.Get(len) && r.GetString(s, len);
+            if (ok) {
+                if (rec.names.size() < id)
+                    rec.names.resize(id);
+                rec.names[id - 1] = s;
+            }
+        } else if (kind == RecordFormat::Dropped) {
+            uint64_t count;
+            ok = r.Get(count);
+            if (ok) rec.dropped += count;
+        } else if (kind >= RecordFormat::FirstEvent &&
+                kind <= RecordFormat::LastEvent) {
+            Event e = {};
+            uint16_t name = 0;
+            e.kind = kind;
+            ok = r.Get(e.tsc);
+            switch (kind) {
+                case RecordFormat::WeaponSelected:
+                case RecordFormat::SelectWeaponByDecl:
+                case RecordFormat::LevelStartWeapon:
+                    ok = ok && r.Get(e.object) && r.Get(name);
+                    break;
+                case RecordFormat::UpdateWeapon:
+                    ok = ok && r.Get(e.object);
+                    break;
+                case RecordFormat::AmmoUpdate:
+                    ok = ok && r.Get(e.object) && r.Get(e.value);
+                    break;
+                case RecordFormat::FireModeSet:
+                    ok = ok && r.Get(e.flag) && r.Get(e.value);
+                    break;
+                case RecordFormat::PlayerDamaged:
+                    ok = ok && r.Get(e.flag);
+                    break;
+                default:
+                    break;
+            }
+            if (ok) {
+                rec.events.push_back(e);
+                nameIds.push_back(name);
+            }
+        } else {
+            fprintf(stderr, "corrupt record (kind %u) at offset %zu\n",
+                    kind, r.Pos() - 1);
+            return false;
+        }
+
+        if (!ok) {
+            // the game may still be writing, or it crashed mid-flush
+            fprintf(stderr, "truncated record at offset %zu\n", r.Pos());
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < rec.events.size(); i++) {
+        const uint16_t id = nameIds[i];
+        rec.events[i].name = id && id <= rec.names.size() ?
+            rec.names[id - 1].c_str() : nullptr;
+    }
+    return true;
+}
+
+// Stands in for the DualSensitive client: counts what would have been sent
+class MockSink : public TriggerSink
+{
+public:
+    uint64_t sends = 0;
+    uint64_t resets = 0;
+    uint64_t noAmmos = 0;
+    uint64_t digest = 1469598103934665603ull;     // FNV-1a
+    bool print = false;
+    double nowMs = 0;
+
+    void SendWeapon(const char *weaponId) override {
+        sends++;
+        Mix('S');
+        for (const char *c = weaponId; *c; c++)
+            Mix((uint8_t)*c);
+        if (print)
+            printf("[%12.3f ms] send %s\n", nowMs, weaponId);
+    }
+
+    void Reset() override {
+        resets++;
+        Mix('R');
+        if (print)
+            printf("[%12.3f ms] reset\n", nowMs);
+    }
+
+    void NoAmmo() override {
+        noAmmos++;
+        Mix('N');
+        if (print)
+            printf("[%12.3f ms] no ammo\n", nowMs);
+    }
+
+private:
+    void Mix(uint8_t byte) {
+        digest ^= byte;
+        digest *= 1099511628211ull;
+    }
+};
+
+static MockSink g_sink;
+static std::atomic<uint64_t> g_detectedPauses{0};
+
+static void OnPause() {
+    g_detectedPauses.fetch_add(1, std::memory_order_relaxed);
+    Pipeline::OnPaused();
+}
+
+static void Dispatch(const Event& e, bool livePauses) {
+    const void *object = (const void *)(uintptr_t)e.object;
+    switch (e.kind) {
+        case RecordFormat::WeaponSelected:
+            Pipeline::OnWeaponSelected(object, e.name);
+            break;
+        case RecordFormat::SelectWeaponByDecl:
+            Pipeline::OnSelectWeaponByDecl(object, e.name);
+            break;
+        case RecordFormat::SelectWeaponByDeclDone:
+            Pipeline::OnSelectWeaponByDeclDone();
+            break;
+        case RecordFormat::UpdateWeapon:
+            Pipeline::OnUpdateWeapon(object);
+            break;
+        case RecordFormat::AmmoUpdate:
+            Pipeline::OnAmmoUpdate(object, (int32_t)e.value);
+            break;
+        case RecordFormat::FireModeSet:
+            Pipeline::OnFireModeSet(e.flag != 0, e.value);
+            break;
+        case RecordFormat::HandsTick:
+            Pipeline::OnHandsTick();
+            break;
+        case RecordFormat::PlayerDamaged:
+            Pipeline::OnPlayerDamaged(e.flag != 0);
+            break;
+        case RecordFormat::LevelLoaded:
+            // when this starts gameplay, the weapon the game reported comes
+            // next as LevelStartWeapon
+            Pipeline::OnLevelLoaded();
+            break;
+        case RecordFormat::LevelStartWeapon:
+            Pipeline::OnLevelStartWeapon(object, e.name);
+            break;
+        case RecordFormat::Paused:
+            // what the pause watcher does once the heartbeat stops
+            if (!livePauses && FSM::Get() == GameState::InGame) {
+                FSM::Set(GameState::Paused);
+                OnPause();
+            }
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.rec> [--iterations N] [--realtime] "
+                "[--threshold MS] [--print] [--log FILE]\n", argv[0]);
+        return 1;
+    }
+    int iterations = 1;
+    bool realtime = false;
+    uint64_t thresholdMs = 350;
+    const char *logPath = nullptr;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--realtime"))
+            realtime = true;
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+            thresholdMs = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--print"))
+            g_sink.print = true;
+        else if (!strcmp(argv[i], "--log") && i + 1 < argc)
+            logPath = argv[++i];
+        else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    Recording rec;
+    if (!Load(argv[1], rec))
+        return 1;
+    if (rec.events.empty()) {
+        fprintf(stderr, "%s: no events\n", argv[1]);
+        return 1;
+    }
+
+    if (logPath) {
+        // the pipeline's own debug logs, for diffing against the game's
+        if (!Logger::Open(logPath)) {
+            perror(logPath);
+            return 1;
+        }
+        g_config.isDebugMode = true;
+        g_config.logMask = LOG_DEBUG_BIT(LOG_ALL);
+    }
+
+    const double recTicksPerUs = rec.header.ticksPerUs;
+    const double sessionMs = (rec.events.back().tsc - rec.header.startTsc) /
+        recTicksPerUs / 1000.0;
+    uint64_t counts[RecordFormat::LastEvent + 1] = {};
+    for (const Event& e : rec.events)
+        counts[e.kind]++;
+    printf("%s: %zu events over %.1f s, %zu weapon name(s), %llu dropped "
+            "while recording\n", argv[1], rec.events.size(), sessionMs / 1000,
+            rec.names.size(), (unsigned long long)rec.dropped);
+
+    Pipeline::SetSink(&g_sink);
+    Histogram perKind[RecordFormat::LastEvent + 1];
+    uint64_t firstDigest = 0;
+    bool deterministic = true;
+    double bestMs = 0;
+
+    if (realtime) {
+        iterations = 1;
+        FSM::StartPauseWatcher(thresholdMs, OnPause);
+    }
+
+    for (int it = 0; it < iterations; it++) {
+        FSM::Set(GameState::Idle);
+        Pipeline::Reset();
+        const bool print = g_sink.print;
+        g_sink = MockSink{};
+        g_sink.print = print;
+
+        const auto wallStart = std::chrono::steady_clock::now();
+        for (const Event& e : rec.events) {
+            const double eventMs =
+                (e.tsc - rec.header.startTsc) / recTicksPerUs / 1000.0;
+            if (realtime) {
+                std::this_thread::sleep_until(wallStart +
+                        std::chrono::duration_cast<
+                            std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double, std::milli>(
+                                eventMs)));
+            }
+            g_sink.nowMs = eventMs;
+            const uint64_t start = Tsc::Now();
+            Dispatch(e, realtime);
+            perKind[e.kind].Record(Tsc::Now() - start);
+        }
+        const double elapsedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - wallStart).count();
+        if (!it || elapsedMs < bestMs)
+            bestMs = elapsedMs;
+
+        if (!it)
+            firstDigest = g_sink.digest;
+        else if (g_sink.digest != firstDigest)
+            deterministic = false;
+    }
+
+    if (realtime)
+        FSM::StopPauseWatcher();
+
+    const double ticksPerNs = Tsc::TicksPerUs() / 1000.0;
+    printf("\n%-24s %10s %10s %10s %10s\n", "event", "count", "p50 ns",
+            "p99 ns", "max ns");
+    for (int k = RecordFormat::FirstEvent; k <= RecordFormat::LastEvent; k++) {
+        if (!counts[k])
+            continue;
+        const Histogram& h = perKind[k];
+        printf("%-24s %10llu %10.0f %10.0f %10.0f\n",
+                RecordFormat::ToString((uint8_t)k),
+                (unsigned long long)counts[k],
+                h.Percentile(50) / ticksPerNs,
+                h.Percentile(99) / ticksPerNs,
+                h.Max() / ticksPerNs);
+    }
+
+    printf("\ntrigger commands: %llu send(s), %llu reset(s), %llu no-ammo\n",
+            (unsigned long long)g_sink.sends,
+            (unsigned long long)g_sink.resets,
+            (unsigned long long)g_sink.noAmmos);
+    if (realtime) {
+        printf("pauses: %llu recorded, %llu detected by the watcher "
+                "(threshold %llu ms)\n",
+                (unsigned long long)counts[RecordFormat::Paused],
+                (unsigned long long)g_detectedPauses.load(),
+                (unsigned long long)thresholdMs);
+    } else {
+        printf("replay: %d iteration(s), best %.3f ms (%.0f events/s)%s\n",
+                iterations, bestMs, rec.events.size() / (bestMs / 1000.0),
+                deterministic ? "" : " -- NOT DETERMINISTIC");
+    }
+    printf("digest: %016llx\n", (unsigned long long)g_sink.digest);
+
+    if (logPath)
+        Logger::Close();
+    return deterministic ? 0 : 2;
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// dualsensitive-service stand-in
+//
+// A loopback UDP server that takes the place of the Windows service, so the
+// client side of the transport can be exercised on a Linux box without a
+// controller. It doesn't interpret what it receives: every datagram is
+// recorded as-is (arrival time, source, hex payload), so it works with
+// whatever the client library sends, and faults can be injected on the way
+// in:
+//
+//   --delay-us US      processing time per datagram (a slow service / HID
+//                      write); datagrams queue up in the socket meanwhile
+//   --loss P           drop that fraction of the datagrams
+//   --restart-every MS close the socket and bind it again after
+//                      --restart-down-ms, as a service restart would
+//
+// "serve" runs the stand-in on the given port until interrupted. "bench"
+// runs it in-process on an ephemeral port and sends stamped datagrams to it
+// at each of the given rates, reporting throughput, losses and send-to-
+// receive latency percentiles.
+//
+// usage: service-standin serve --port N [--out FILE] [faults]
+//        service-standin bench [--rates R1,R2,...] [--seconds S]
+//                              [--size BYTES] [faults]
+
+#include "HookStats.h"
+#include "Logger.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+Config g_config;
+Logger g_logger;
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+}
+
+struct Faults {
+    uint64_t delayUs = 0;
+    double loss = 0;
+    uint64_t restartEveryMs = 0;
+    uint64_t restartDownMs = 50;
+};
+
+// What bench datagrams start with; the rest is padding up to --size
+struct BenchHeader {
+    char magic[4];          // "DSMB"
+    uint32_t seq;
+    uint64_t sentNs;
+};
+
+static constexpr char kBenchMagic[4] = { 'D', 'S', 'M', 'B' };
+
+class StandIn
+{
+public:
+    Histogram latency;      // ns, bench datagrams only
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> dropped{0};       // by --loss
+    std::atomic<uint64_t> restarts{0};
+
+    StandIn(uint16_t port, const Faults& faults, FILE *out)
+        : m_port(port), m_faults(faults), m_out(out) {}
+
+    ~StandIn() {
+        Stop();
+        if (m_socket >= 0)
+            close(m_socket);
+    }
+
+    bool Start() {
+        if (!Bind())
+            return false;
+        m_thread = std::thread([this] { Loop(); });
+        return true;
+    }
+
+    void Stop() {
+        m_stop.store(true, std::memory_order_relaxed);
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    uint16_t Port() const { return m_port; }
+
+private:
+    uint16_t m_port;
+    Faults m_faults;
+    FILE *m_out;
+    int m_socket = -1;
+    std::atomic<bool> m_stop{false};
+    std::thread m_thread;
+
+    bool Bind() {
+        m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (m_socket < 0)
+            return false;
+        int one = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        int bufferSize = 4 << 20;
+        setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &bufferSize,
+                sizeof(bufferSize));
+        // wake up regularly to notice Stop() and scheduled restarts
+        timeval timeout = { 0, 50 * 1000 };
+        setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                sizeof(timeout));
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(m_port);
+        if (bind(m_socket, (sockaddr *)&addr, sizeof(addr)) < 0) {
+            close(m_socket);
+            m_socket = -1;
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(m_socket, (sockaddr *)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        return true;
+    }
+
+    void Restart() {
+        close(m_socket);
+        m_socket = -1;
+        std::this_thread::sleep_for(
+                std::chrono::milliseconds(m_faults.restartDownMs));
+        while (!Bind() && !m_stop.load(std::memory_order_relaxed))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Loop() {
+        std::mt19937_64 rng(0x5eed);
+        std::uniform_real_distribution<double> roll(0.0, 1.0);
+        std::vector<char> buf(65536);
+        const uint64_t startNs = NowNs();
+        uint64_t nextRestartNs = m_faults.restartEveryMs ?
+            startNs + m_faults.restartEveryMs * 1000000 : UINT64_MAX;
+
+        while (!m_stop.load(std::memory_order_relaxed)) {
+            if (NowNs() >= nextRestartNs) {
+                Restart();
+                nextRestartNs = NowNs() + m_faults.restartEveryMs * 1000000;
+            }
+
+            sockaddr_in from = {};
+            socklen_t fromLen = sizeof(from);
+            const ssize_t n = recvfrom(m_socket, buf.data(), buf.size(), 0,
+                    (sockaddr *)&from, &fromLen);
+            if (n < 0)
+                continue;
+            const uint64_t arrivalNs = NowNs();
+
+            if (m_faults.loss > 0 && roll(rng) < m_faults.loss) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (m_faults.delayUs) {
+                const uint64_t until = arrivalNs + m_faults.delayUs * 1000;
+                while (NowNs() < until)
+                    ;
+            }
+            received.fetch_add(1, std::memory_order_relaxed);
+
+            BenchHeader header;
+            if ((size_t)n >= sizeof(header)) {
+                memcpy(&header, buf.data(), sizeof(header));
+                if (!memcmp(header.magic, kBenchMagic, sizeof(kBenchMagic)))
+                    latency.Record(NowNs() - header.sentNs);
+            }
+
+            if (m_out) {
+                char addr[INET_ADDRSTRLEN] = "?";
+                inet_ntop(AF_INET, &from.sin_addr, addr, sizeof(addr));
+                fprintf(m_out, "%.3f %s:%u %zd ",
+                        (arrivalNs - startNs) / 1000.0, addr,
+                        ntohs(from.sin_port), n);
+                for (ssize_t i = 0; i < n; i++)
+                    fprintf(m_out, "%02x", (unsigned char)buf[i]);
+                fputc('\n', m_out);
+            }
+        }
+        if (m_out)
+            fflush(m_out);
+    }
+};
+
+static std::atomic<bool> g_interrupted{false};
+
+static void OnSignal(int) {
+    g_interrupted.store(true);
+}
+
+static int Serve(uint16_t port, const Faults& faults, const char *outPath) {
+    FILE *out = stdout;
+    if (outPath && !(out = fopen(outPath, "w"))) {
+        fprintf(stderr, "Failed to open %s\n", outPath);
+        return 1;
+    }
+    StandIn standIn(port, faults, out);
+    if (!standIn.Start()) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%u\n", port);
+        return 1;
+    }
+    fprintf(stderr, "listening on 127.0.0.1:%u; one line per datagram: "
+            "arrival (us), source, length, payload\n", standIn.Port());
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    while (!g_interrupted.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    standIn.Stop();
+
+    fprintf(stderr, "received: %llu, dropped: %llu, restarts: %llu\n",
+            (unsigned long long)standIn.received.load(),
+            (unsigned long long)standIn.dropped.load(),
+            (unsigned long long)standIn.restarts.load());
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
+
+static void BenchRate(const Faults& faults, double rate, double seconds,
+        size_t size) {
+    StandIn standIn(0, faults, nullptr);
+    if (!standIn.Start()) {
+        fprintf(stderr, "Failed to bind a loopback port\n");
+        return;
+    }
+
+    // the client side: a connected UDP socket, as a transport client would
+    const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(standIn.Port());
+    connect(sock, (sockaddr *)&addr, sizeof(addr));
+
+    std::vector<char> payload(std::max(size, sizeof(BenchHeader)), 0);
+    uint64_t sent = 0, sendErrors = 0;
+    const auto start = Clock::now();
+    const auto duration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    Histogram sendCost;
+    for (;;) {
+        const auto now = Clock::now();
+        if (now - start >= duration)
+            break;
+        const auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((sent + sendErrors) / rate));
+        if (now < due)
+            continue;
+
+        BenchHeader header;
+        memcpy(header.magic, kBenchMagic, sizeof(header.magic));
+        header.seq = (uint32_t)(sent + sendErrors);
+        header.sentNs = NowNs();
+        memcpy(payload.data(), &header, sizeof(header));
+        // refused while the stand-in is restarting
+        if (send(sock, payload.data(), payload.size(), 0) < 0)
+            sendErrors++;
+        else
+            sent++;
+        sendCost.Record(NowNs() - header.sentNs);
+    }
+    const double elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    // let the stand-in drain what's still queued
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    standIn.Stop();
+    close(sock);
+
+    const uint64_t received = standIn.received.load();
+    const uint64_t dropped = standIn.dropped.load();
+    const uint64_t lost = sent > received + dropped ?
+        sent - received - dropped : 0;
+    const Histogram& h = standIn.latency;
+    printf("%9.0f %9.0f %9.0f %8llu %8llu %8llu %6llu %8.1f %8.1f %8.1f %8.1f "
+            "%8.1f\n",
+            rate, sent / elapsed, received / elapsed,
+            (unsigned long long)dropped, (unsigned long long)lost,
+            (unsigned long long)sendErrors,
+            (unsigned long long)standIn.restarts.load(),
+            sendCost.Percentile(50) / 1000.0,
+            h.Percentile(50) / 1000.0, h.Percentile(99) / 1000.0,
+            h.Percentile(99.9) / 1000.0, h.Max() / 1000.0);
+    fflush(stdout);
+}
+
+static std::vector<double> ParseRates(const char *list) {
+    std::vector<double> rates;
+    while (*list) {
+        char *end = nullptr;
+        const double rate = strtod(list, &end);
+        if (end == list)
+            break;
+        if (rate > 0)
+            rates.push_back(rate);
+        list = *end == ',' ? end + 1 : end;
+    }
+    return rates;
+}
+
+static int Usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s serve --port N [--out FILE] [faults]\n"
+            "       %s bench [--rates R1,R2,...] [--seconds S] [--size BYTES] "
+            "[faults]\n"
+            "faults: [--delay-us US] [--loss P] [--restart-every MS] "
+            "[--restart-down-ms MS]\n", argv0, argv0);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        return Usage(argv[0]);
+    const bool serve = !strcmp(argv[1], "serve");
+    if (!serve && strcmp(argv[1], "bench"))
+        return Usage(argv[0]);
+
+    Faults faults;
+    long port = -1;
+    const char *outPath = nullptr;
+    std::vector<double> rates = { 1000, 10000, 100000 };
+    double seconds = 1.0;
+    size_t size = 64;
+
+    for (int i = 2; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--port") && hasValue) {
+            port = strtol(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--out") && hasValue) {
+            outPath = argv[++i];
+        } else if (!strcmp(argv[i], "--rates") && hasValue) {
+            rates = ParseRates(argv[++i]);
+        } else if (!strcmp(argv[i], "--seconds") && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--size") && hasValue) {
+            size = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--delay-us") && hasValue) {
+            faults.delayUs = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--loss") && hasValue) {
+            faults.loss = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--restart-every") && hasValue) {
+            faults.restartEveryMs = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--restart-down-ms") && hasValue) {
+            faults.restartDownMs = strtoull(argv[++i], nullptr, 10);
+        } else {
+            return Usage(argv[0]);
+        }
+    }
+
+    if (serve) {
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "serve needs the --port the client sends to\n");
+            return 1;
+        }
+        return Serve((uint16_t)port, faults, outPath);
+    }
+
+    if (rates.empty() || seconds <= 0) {
+        fprintf(stderr, "Invalid rates or duration\n");
+        return 1;
+    }
+    // a restarting stand-in makes sends fail with ECONNREFUSED, not kill us
+    signal(SIGPIPE, SIG_IGN);
+    printf("%zu-byte datagrams, %.1f s per rate, delay: %llu us, loss: %.3f, "
+            "restart every: %llu ms\n\n", std::max(size, sizeof(BenchHeader)),
+            seconds, (unsigned long long)faults.delayUs, faults.loss,
+            (unsigned long long)faults.restartEveryMs);
+    printf("%9s %9s %9s %8s %8s %8s %6s %8s %8s %8s %8s %8s\n",
+            "target/s", "sent/s", "recv/s", "dropped", "lost", "refused",
+            "restrt", "send us", "p50 us", "p99 us", "p99.9 us", "max us");
+    for (double rate : rates)
+        BenchRate(faults, rate, seconds, size);
+    return 0;
+}
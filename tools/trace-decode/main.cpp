@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2025 Thanasis Petsas <thanpetsas@gmail.com>
+ * Licence: MIT Licence
+ */
+
+// Binary trace decoder
+//
+// Turns a dualsensemod.trace file (written when trace=true) back into the
+// text the _LOGD sites would have logged, prefixed with the time since the
+// trace was opened.
+//
+// usage: trace-decode <file.trace> [--sites]
+
+#include "TraceFormat.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Site {
+    std::string file;
+    uint32_t line = 0;
+    std::string format;
+};
+
+struct Arg {
+    uint8_t type;
+    uint64_t value;
+};
+
+class Reader
+{
+public:
+    explicit Reader(std::vector<char> data) : m_data(std::move(data)) {}
+
+    bool AtEnd() const { return m_pos >= m_data.size(); }
+
+    template <typename T>
+    bool Get(T& out) {
+        if (m_pos + sizeof(T) > m_data.size()) return false;
+        memcpy(&out, m_data.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string& out) {
+        uint16_t len;
+        if (!Get(len) || m_pos + len > m_data.size()) return false;
+        out.assign(m_data.data() + m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    size_t Pos() const { return m_pos; }
+
+private:
+    std::vector<char> m_data;
+    size_t m_pos = 0;
+};
+
+static std::unordered_map<uint16_t, Site> g_sites;
+static std::unordered_map<uint32_t, std::string> g_strings;
+
+static const char *StringArg(uint64_t id) {
+    if (!id) return "(null)";
+    auto it = g_strings.find((uint32_t)id);
+    return it != g_strings.end() ? it->second.c_str() : "(?)";
+}
+
+// printf-style formatting against the recorded (typed) arguments
+static std::string Format(const std::string& format,
+        const std::vector<Arg>& args) {
+    std::string out;
+    size_t next = 0;
+    char buf[512];
+
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] != '%') {
+            out += format[i];
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '%') {
+            out += '%';
+            i++;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion
+        size_t end = i + 1;
+        std::string spec = "%";
+        while (end < format.size() && strchr("-+ #0", format[end]))
+            spec += format[end++];
+        while (end < format.size() &&
+                (isdigit((unsigned char)format[end]) || format[end] == '.'))
+            spec += format[end++];
+        while (end < format.size() && strchr("hlLzjt", format[end]))
+            end++; // length modifiers: we always format 64-bit values
+        if (end >= format.size())
+            break;
+        const char conv = format[end];
+        i = end;
+
+        if (next >= args.size()) {
+            out += "(missing)";
+            continue;
+        }
+        const Arg& a = args[next++];
+
+        switch (conv) {
+            case 'd': case 'i':
+                snprintf(buf, sizeof(buf), (spec + "lld").c_str(),
+                        (long long)a.value);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(),
+                        (unsigned long long)a.value);
+                break;
+            case 'c':
+                snprintf(buf, sizeof(buf), (spec + "c").c_str(), (int)a.value);
+                break;
+            case 'p':
+                snprintf(buf, sizeof(buf), "0x%016llx",
+                        (unsigned long long)a.value);
+                break;
+            case 's':
+                snprintf(buf, sizeof(buf), (spec + "s").c_str(),
+                        a.type == TraceFormat::Str ? StringArg(a.value) : "(?)");
+                break;
+            case 'f': case 'F': case 'e': case 'E':
+            case 'g': case 'G': case 'a': case 'A': {
+                double d;
+                memcpy(&d, &a.value, sizeof(d));
+                snprintf(buf, sizeof(buf), (spec + conv).c_str(), d);
+                break;
+            }
+            default:
+                snprintf(buf, sizeof(buf), "(%%%c?)", conv);
+        }
+        out += buf;
+    }
+    return out;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.trace> [--sites]\n", argv[0]);
+        return 1;
+    }
+    const bool showSites = argc > 2 && !strcmp(argv[2], "--sites");
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    std::vector<char> data;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    Reader r(std::move(data));
+    TraceFormat::FileHeader header;
+    if (!r.Get(header) ||
+            memcmp(header.magic, TraceFormat::kMagic, sizeof(header.magic))) {
+        fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        return 1;
+    }
+    if (header.version != TraceFormat::kVersion) {
+        fprintf(stderr, "%s: unsupported trace version %u\n",
+                argv[1], header.version);
+        return 1;
+    }
+
+    uint64_t events = 0, dropped = 0;
+    while (!r.AtEnd()) {
+        uint8_t kind = 0;
+        r.Get(kind);
+        bool ok = true;
+
+        if (kind == TraceFormat::SiteDef) {
+            uint16_t id;
+            Site s;
+            ok = r.Get(id) && r.Get(s.line) && r.GetString(s.file) &&
+                r.GetString(s.format);
+            if (ok) g_sites[id] = s;
+        } else if (kind == TraceFormat::StringDef) {
+            uint32_t id;
+            std::string s;
+            ok = r.Get(id) && r.GetString(s);
+            if (ok) g_strings[id] = s;
+        } else if (kind == TraceFormat::Event) {
+            uint16_t site;
+            uint64_t tsc;
+            uint8_t nargs;
+            ok = r.Get(site) && r.Get(tsc) && r.Get(nargs) &&
+                nargs <= TraceFormat::kMaxArgs;
+            std::vector<Arg> args(ok ? nargs : 0);
+            for (auto& a : args)
+                ok = ok && r.Get(a.type) && r.Get(a.value);
+            if (!ok) {
+                fprintf(stderr, "truncated record at offset %zu\n", r.Pos());
+                break;
+            }
+
+            const double ms = (double)(int64_t)(tsc - header.startTsc) /
+                header.ticksPerUs / 1000.0;
+            auto it = g_sites.find(site);
+            if (it == g_sites.end()) {
+                printf("[%12.3f ms] (unknown site %u)\n", ms, site);
+            } else if (showSites) {
+                printf("[%12.3f ms] %s:%u: %s\n", ms, it->second.file.c_str(),
+                        it->second.line,
+                        Format(it->second.format, args).c_str());
+            } else {
+                printf("[%12.3f ms] %s\n", ms,
+                        Format(it->second.format, args).c_str());
+            }
+            events++;
+        } else if (kind == TraceFormat::Dropped) {
+            uint64_t count;
+            ok = r.Get(count);
+            if (ok) {
+                dropped += count;
+                printf("[  (dropped) ] %llu event(s) lost (ring full)\n",
+                        (unsigned long long)count);
+            }
+        } else {
+            fprintf(stderr, "corrupt record (kind %u) at offset %zu\n",
+                    kind, r.Pos() - 1);
+            return 1;
+        }
+
+        if (!ok) {
+            // the game may still be writing, or it crashed mid-flush
+            fprintf(stderr, "truncated record at offset %zu\n", r.Pos());
+            break;
+        }
+    }
+
+    fprintf(stderr, "%llu event(s), %llu dropped, %zu site(s), "
+            "%zu string(s)\n", (unsigned long long)events,
+            (unsigned long long)dropped, g_sites.size(), g_strings.size());
+    return 0;
+}